@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_BUS_H
+#define MCE_BUS_H
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * By default the library uses the process-wide shared system bus
+ * connection. A private connection keeps MCE signals from queuing
+ * behind unrelated (possibly bulky) traffic of other libraries, and
+ * signals of the MCE backend in use (see below) received over it are
+ * dispatched at the given priority (G_PRIORITY_HIGH by default) rather
+ * than at the default one. Takes effect the next time the library
+ * connects to the bus, i.e. should be configured before the first MCE
+ * object is created.
+ *
+ * Only the private connection delivers Unity.Screen display state
+ * signals to the MceDisplay handlers without allocating memory on the
+ * thread running the main context (once warmed up, and provided that
+ * mce_cache.h is disabled). On the shared connection GDBus allocates
+ * for every signal and subscriber, and the GDBus worker thread always
+ * allocates while reading the messages.
+ */
+
+void
+mce_bus_set_private(
+    gboolean enabled);
+
+gboolean
+mce_bus_private(
+    void);
+
+void
+mce_bus_set_priority(
+    int priority);
+
+int
+mce_bus_priority(
+    void);
+
+/*
+ * Display and tklock state can come either from the Unity.Screen
+ * interface or from the native com.nokia.mce one. By default the
+ * backend is detected when the library first connects to the bus,
+ * preferring native mce, so that a Unity.Screen translation shim
+ * running on top of it is bypassed. Like the settings above, takes
+ * effect the next time the library connects to the bus.
+ */
+
+typedef enum mce_backend {
+    MCE_BACKEND_AUTO,
+    MCE_BACKEND_UNITY,
+    MCE_BACKEND_NOKIA
+} MCE_BACKEND;
+
+void
+mce_bus_set_backend(
+    MCE_BACKEND backend);
+
+MCE_BACKEND
+mce_bus_backend(
+    void);
+
+G_END_DECLS
+
+#endif /* MCE_BUS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_CALL_H
+#define MCE_CALL_H
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Configuration of the method calls issued by the library. These
+ * settings are shared by all MCE objects in the process.
+ */
+
+#define MCE_CALL_TIMEOUT_DEFAULT (-1) /* D-Bus default, about 25 sec */
+
+void
+mce_call_set_timeout(
+    int timeout_ms);
+
+int
+mce_call_timeout(
+    void);
+
+/*
+ * Hedging issues a second identical query if the first one hasn't
+ * been answered within the given percentile of the observed call
+ * latency, and takes whichever reply arrives first. Zero disables
+ * hedging (which is the default).
+ */
+
+void
+mce_call_set_hedging(
+    guint percentile);
+
+guint
+mce_call_hedging(
+    void);
+
+/* Latencies are in microseconds */
+typedef struct mce_call_stats {
+    guint calls;        /* Completed calls */
+    guint failed;       /* Failed calls, including timeouts */
+    guint hedged;       /* Calls for which a hedge request was issued */
+    guint hedge_won;    /* Calls completed by the hedge request */
+    guint samples;      /* Latency samples the percentiles are based on */
+    guint latency_min;
+    guint latency_p50;
+    guint latency_p90;
+    guint latency_p99;
+    guint latency_max;
+    guint hedge_delay;  /* Current hedge delay */
+    guint reconnects;   /* System bus reconnects */
+    guint recovery;     /* Last time from bus loss to MCE being valid */
+} MceCallStats;
+
+void
+mce_call_get_stats(
+    MceCallStats* stats);
+
+guint
+mce_call_latency_percentile(
+    guint percentile);
+
+G_END_DECLS
+
+#endif /* MCE_CALL_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
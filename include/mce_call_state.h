@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_CALL_STATE_H
+#define MCE_CALL_STATE_H
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+typedef enum mce_call_state_state {
+    MCE_CALL_STATE_NONE,
+    MCE_CALL_STATE_RINGING,
+    MCE_CALL_STATE_ACTIVE,
+    MCE_CALL_STATE_SERVICE
+} MCE_CALL_STATE_STATE;
+
+typedef enum mce_call_type {
+    MCE_CALL_TYPE_NORMAL,
+    MCE_CALL_TYPE_EMERGENCY
+} MCE_CALL_TYPE;
+
+typedef struct mce_call_state_priv MceCallStatePriv;
+
+typedef struct mce_call_state {
+    GObject object;
+    MceCallStatePriv* priv;
+    gboolean valid;
+    MCE_CALL_STATE_STATE state;
+    MCE_CALL_TYPE type;
+} MceCallState;
+
+typedef void
+(*MceCallStateFunc)(
+    MceCallState* call,
+    void* arg);
+
+MceCallState*
+mce_call_state_new(
+    void);
+
+MceCallState*
+mce_call_state_ref(
+    MceCallState* call);
+
+void
+mce_call_state_unref(
+    MceCallState* call);
+
+gulong
+mce_call_state_add_valid_changed_handler(
+    MceCallState* call,
+    MceCallStateFunc fn,
+    void* arg);
+
+gulong
+mce_call_state_add_state_changed_handler(
+    MceCallState* call,
+    MceCallStateFunc fn,
+    void* arg);
+
+gulong
+mce_call_state_add_type_changed_handler(
+    MceCallState* call,
+    MceCallStateFunc fn,
+    void* arg);
+
+gulong
+mce_call_state_add_valid_changed_handler_full(
+    MceCallState* call,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg);
+
+gulong
+mce_call_state_add_state_changed_handler_full(
+    MceCallState* call,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg);
+
+gulong
+mce_call_state_add_type_changed_handler_full(
+    MceCallState* call,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg);
+
+void
+mce_call_state_remove_handler(
+    MceCallState* call,
+    gulong id);
+
+void
+mce_call_state_remove_handlers(
+    MceCallState* call,
+    gulong *ids,
+    guint count);
+
+#define mce_call_state_remove_all_handlers(c, ids) \
+	mce_call_state_remove_handlers(c, ids, G_N_ELEMENTS(ids))
+
+G_END_DECLS
+
+#endif /* MCE_CALL_STATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -53,6 +53,7 @@ typedef struct mce_display {
     MceDisplayPriv* priv;
     gboolean valid;
     MCE_DISPLAY_STATE state;
+    gboolean provisional; /* State comes from mce_cache.h, not MCE */
 } MceDisplay;
 
 typedef void
@@ -72,6 +73,29 @@ void
 mce_display_unref(
     MceDisplay* display);
 
+/*
+ * Invokes the callback right away (and returns TRUE) if the cached
+ * state has been confirmed by MCE within the last max_age_ms
+ * milliseconds. Otherwise, submits a query (or joins the one which
+ * is already in progress) and invokes the callback when it completes,
+ * successfully or not. The fresh flag tells which one it was. If it's
+ * FALSE, the state is just the last known one (if valid at all), and
+ * stays that way until MCE tells otherwise.
+ */
+
+typedef void
+(*MceDisplayFreshFunc)(
+    MceDisplay* display,
+    gboolean fresh,
+    void* arg);
+
+gboolean
+mce_display_get_state_fresh(
+    MceDisplay* display,
+    guint max_age_ms,
+    MceDisplayFreshFunc fn,
+    void* arg);
+
 gulong
 mce_display_add_valid_changed_handler(
     MceDisplay* display,
@@ -84,6 +108,54 @@ mce_display_add_state_changed_handler(
     MceDisplayFunc fn,
     void* arg);
 
+gulong
+mce_display_add_valid_changed_handler_full(
+    MceDisplay* display,
+    MCE_PRIORITY priority,
+    MceDisplayFunc fn,
+    void* arg);
+
+gulong
+mce_display_add_state_changed_handler_full(
+    MceDisplay* display,
+    MCE_PRIORITY priority,
+    MceDisplayFunc fn,
+    void* arg);
+
+/*
+ * These handlers are invoked in the thread-default main context of
+ * the thread which has registered them. Notifications are batched,
+ * each state transition wakes up each context only once regardless
+ * of the number of handlers registered in it. Handlers are removed
+ * with mce_display_remove_handler() as usual.
+ */
+
+gulong
+mce_display_add_valid_changed_handler_in_context(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg);
+
+gulong
+mce_display_add_state_changed_handler_in_context(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg);
+
+/*
+ * Returns a new GSource which dispatches every interval_ms milliseconds
+ * but only while the display is in the given state. While the display
+ * is in any other state (or its state is unknown) the source doesn't
+ * wake up the main loop at all. If the interval has expired while the
+ * source was gated off, it gets dispatched as soon as it opens. Attach
+ * it with g_source_attach() and set the callback the usual way.
+ */
+GSource*
+mce_display_gated_source_new(
+    MceDisplay* display,
+    MCE_DISPLAY_STATE state,
+    guint interval_ms);
+
 void
 mce_display_remove_handler(
     MceDisplay* display,
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_EVENT_QUEUE_H
+#define MCE_EVENT_QUEUE_H
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Pull-based alternative to the change handlers. The queue collects
+ * state transitions of the objects added to it (MceDisplay, MceBattery,
+ * MceCharger, MceCallState, MceInactivity and MceTklock) and signals
+ * readiness via an eventfd, which stays readable while the queue is
+ * not empty. The consumer drains the queue with
+ * mce_event_queue_pop_batch() on its own schedule. Events are queued
+ * synchronously as the objects emit their change signals, i.e. on the
+ * thread running the main loop the objects live in.
+ *
+ * The consumer may live on a different thread. The queue is locked,
+ * mce_event_queue_fd(), mce_event_queue_pop_batch() and
+ * mce_event_queue_dropped() can be called from any thread. The rest
+ * of the functions must be called on the thread the objects live on.
+ */
+
+typedef struct mce_event_queue MceEventQueue;
+
+typedef enum mce_event_type {
+    MCE_EVENT_VALID,            /* value is the valid flag */
+    MCE_EVENT_DISPLAY_STATE,    /* MCE_DISPLAY_STATE */
+    MCE_EVENT_BATTERY_LEVEL,    /* Percents */
+    MCE_EVENT_BATTERY_STATUS,   /* MCE_BATTERY_STATUS */
+    MCE_EVENT_CHARGER_STATE,    /* MCE_CHARGER_STATE */
+    MCE_EVENT_CALL_STATE,       /* MCE_CALL_STATE_STATE */
+    MCE_EVENT_CALL_TYPE,        /* MCE_CALL_TYPE */
+    MCE_EVENT_INACTIVITY,       /* MceInactivity status */
+    MCE_EVENT_TKLOCK_MODE,      /* MCE_TKLOCK_MODE */
+    MCE_EVENT_TKLOCK_LOCKED     /* MceTklock locked flag */
+} MCE_EVENT_TYPE;
+
+typedef enum mce_event_reason {
+    MCE_EVENT_REASON_CHANGE,    /* MCE has announced a change */
+    MCE_EVENT_REASON_SYNC,      /* State fetched when (re)connecting */
+    MCE_EVENT_REASON_LOST       /* MCE is gone, the object is invalid */
+} MCE_EVENT_REASON;
+
+typedef enum mce_event_queue_overflow {
+    /* Discard the oldest event */
+    MCE_EVENT_QUEUE_DROP_OLDEST,
+    /*
+     * Discard an event superseded by a newer one of the same kind from
+     * the same object, so that the latest state of each object is never
+     * lost. The capacity grows to the number of kinds if necessary.
+     */
+    MCE_EVENT_QUEUE_KEEP_LATEST
+} MCE_EVENT_QUEUE_OVERFLOW;
+
+typedef struct mce_event {
+    gpointer object;            /* Remains valid while it's in the queue */
+    MCE_EVENT_TYPE type;        /* What has changed */
+    int value;                  /* The new value */
+    MCE_EVENT_REASON reason;    /* Why it has changed */
+    gint64 time;                /* g_get_monotonic_time() of the change */
+} MceEvent;
+
+MceEventQueue*
+mce_event_queue_new(
+    guint capacity,
+    MCE_EVENT_QUEUE_OVERFLOW overflow);
+
+void
+mce_event_queue_free(
+    MceEventQueue* queue);
+
+/* Returns FALSE if the object is of unsupported type */
+gboolean
+mce_event_queue_add(
+    MceEventQueue* queue,
+    gpointer object);
+
+void
+mce_event_queue_remove(
+    MceEventQueue* queue,
+    gpointer object);
+
+int
+mce_event_queue_fd(
+    MceEventQueue* queue);
+
+/*
+ * Copies up to max pending events (oldest first) and removes them from
+ * the queue. Returns the number of events copied. A buffer of the queue
+ * capacity is always large enough to take all of them at once.
+ */
+guint
+mce_event_queue_pop_batch(
+    MceEventQueue* queue,
+    MceEvent* events,
+    guint max);
+
+/* Number of events lost due to overflow */
+guint
+mce_event_queue_dropped(
+    MceEventQueue* queue);
+
+G_END_DECLS
+
+#endif /* MCE_EVENT_QUEUE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_HANDLER_H
+#define MCE_HANDLER_H
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Every invocation of the handlers registered with the *_add_*_handler
+ * functions is timed, including the deferred ones and the ones invoked
+ * in another context. A handler running longer than the budget delays
+ * all other subscribers, and gets reported with a warning, at most
+ * once per 10 seconds per handler. Zero budget disables the warnings.
+ */
+
+#define MCE_HANDLER_BUDGET_DEFAULT (50000) /* microseconds */
+
+void
+mce_handler_set_budget(
+    guint budget_us);
+
+guint
+mce_handler_budget(
+    void);
+
+/* Durations are in microseconds */
+typedef struct mce_handler_stats {
+    const char* signal; /* Signal name */
+    GCallback fn;       /* Handler function */
+    void* arg;          /* Handler argument */
+    guint calls;        /* Number of invocations */
+    guint64 total;      /* Total time spent in the handler */
+    guint max;          /* The longest invocation */
+    guint slow;         /* Invocations which have exceeded the budget */
+} MceHandlerStats;
+
+/*
+ * Fills up to count entries, one per currently connected handler,
+ * in the order of registration. Returns the number of handlers,
+ * which may be larger than count.
+ */
+guint
+mce_handler_get_stats(
+    MceHandlerStats* stats,
+    guint count);
+
+void
+mce_handler_reset_stats(
+    void);
+
+G_END_DECLS
+
+#endif /* MCE_HANDLER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
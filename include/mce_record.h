@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_RECORD_H
+#define MCE_RECORD_H
+
+#include "mce_types.h"
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Recorder writes MCE name owner changes, signals and method call
+ * results received by this process into a compact binary file,
+ * together with their timestamps.
+ */
+
+gboolean
+mce_record_start(
+    const char* path,
+    GError** error);
+
+void
+mce_record_stop(
+    void);
+
+/*
+ * Replay provider feeds the recorded traffic back to the clients
+ * connected to the same bus. It claims the MCE service name on the
+ * given connection, emits the recorded signals and answers method
+ * calls with the recorded results. Normally it's used together with
+ * a private dbus-daemon which the clients under test are pointed to
+ * with DBUS_SYSTEM_BUS_ADDRESS environment variable.
+ */
+
+typedef enum mce_replay_speed {
+    MCE_REPLAY_SPEED_RECORDED,  /* Preserve the recorded timing */
+    MCE_REPLAY_SPEED_FAST       /* As fast as possible */
+} MCE_REPLAY_SPEED;
+
+typedef struct mce_replay_priv MceReplayPriv;
+
+typedef struct mce_replay {
+    GObject object;
+    MceReplayPriv* priv;
+    gboolean active;
+} MceReplay;
+
+typedef void
+(*MceReplayFunc)(
+    MceReplay* replay,
+    void* arg);
+
+MceReplay*
+mce_replay_new(
+    GDBusConnection* bus,
+    const char* path,
+    GError** error);
+
+MceReplay*
+mce_replay_ref(
+    MceReplay* replay);
+
+void
+mce_replay_unref(
+    MceReplay* replay);
+
+gboolean
+mce_replay_start(
+    MceReplay* replay,
+    MCE_REPLAY_SPEED speed);
+
+void
+mce_replay_stop(
+    MceReplay* replay);
+
+gulong
+mce_replay_add_active_changed_handler(
+    MceReplay* replay,
+    MceReplayFunc fn,
+    void* arg);
+
+void
+mce_replay_remove_handler(
+    MceReplay* replay,
+    gulong id);
+
+G_END_DECLS
+
+#endif /* MCE_RECORD_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_STATE_SET_H
+#define MCE_STATE_SET_H
+
+#include "mce_battery.h"
+#include "mce_call_state.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_tklock.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Watches several MCE objects at once. However many of them change
+ * within one main loop iteration, the callback is invoked once, after
+ * all those changes, with the combined state of all the members. The
+ * callback is never invoked synchronously from mce_state_set_add().
+ */
+
+typedef struct mce_state_set MceStateSet;
+
+typedef enum mce_state_member {
+    MCE_STATE_DISPLAY       = 0x01,
+    MCE_STATE_TKLOCK        = 0x02,
+    MCE_STATE_BATTERY       = 0x04,
+    MCE_STATE_CHARGER       = 0x08,
+    MCE_STATE_CALL_STATE    = 0x10,
+    MCE_STATE_INACTIVITY    = 0x20
+} MCE_STATE_MEMBER;
+
+/* Fields of the members not in the set are zero */
+typedef struct mce_state_snapshot {
+    guint members;          /* MCE_STATE_MEMBER bits of the members */
+    guint valid;            /* Members which are valid */
+    guint changed;          /* Members changed since the last callback */
+    MCE_DISPLAY_STATE display_state;
+    MCE_TKLOCK_MODE tklock_mode;
+    gboolean tklock_locked;
+    guint battery_level;
+    MCE_BATTERY_STATUS battery_status;
+    MCE_CHARGER_STATE charger_state;
+    MCE_CALL_STATE_STATE call_state;
+    MCE_CALL_TYPE call_type;
+    gboolean inactive;
+} MceStateSnapshot;
+
+typedef void
+(*MceStateSetFunc)(
+    MceStateSet* set,
+    const MceStateSnapshot* snapshot,
+    void* arg);
+
+MceStateSet*
+mce_state_set_new(
+    MceStateSetFunc fn,
+    void* arg);
+
+void
+mce_state_set_free(
+    MceStateSet* set);
+
+/* Returns FALSE if the object is of unsupported type */
+gboolean
+mce_state_set_add(
+    MceStateSet* set,
+    gpointer object);
+
+void
+mce_state_set_remove(
+    MceStateSet* set,
+    gpointer object);
+
+/* The current state, the changed mask is the one pending delivery */
+void
+mce_state_set_get(
+    MceStateSet* set,
+    MceStateSnapshot* snapshot);
+
+G_END_DECLS
+
+#endif /* MCE_STATE_SET_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -59,6 +59,7 @@ typedef struct mce_tklock {
     gboolean valid;
     MCE_TKLOCK_MODE mode;
     gboolean locked;
+    gboolean provisional; /* Mode comes from mce_cache.h, not MCE */
 } MceTklock;
 
 typedef void
@@ -96,6 +97,27 @@ mce_tklock_add_locked_changed_handler(
     MceTklockFunc fn,
     void* arg);
 
+gulong
+mce_tklock_add_valid_changed_handler_full(
+    MceTklock* tklock,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg);
+
+gulong
+mce_tklock_add_mode_changed_handler_full(
+    MceTklock* tklock,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg);
+
+gulong
+mce_tklock_add_locked_changed_handler_full(
+    MceTklock* tklock,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg);
+
 void
 mce_tklock_remove_handler(
     MceTklock* tklock,
@@ -40,6 +40,19 @@
 #include <glib.h>
 #include <glib-object.h>
 
+G_BEGIN_DECLS
+
+/*
+ * Deferrable handlers aren't invoked while the display is off. They
+ * are invoked once, in one batch, when the display turns back on.
+ */
+typedef enum mce_priority {
+    MCE_PRIORITY_URGENT,
+    MCE_PRIORITY_DEFERRABLE
+} MCE_PRIORITY;
+
+G_END_DECLS
+
 #endif /* MCE_TYPES_H */
 
 /*
@@ -6,9 +6,17 @@ Group: Development/Libraries
 License: BSD
 URL: https://git.merproject.org/mer-core/libmce-glib
 Source: %{name}-%{version}.tar.bz2
+
+# Static tracepoints, "--without sdt" leaves them out
+%bcond_without sdt
+
 BuildRequires:  pkgconfig(glib-2.0)
 BuildRequires:  pkgconfig(libglibutil)
 BuildRequires:  pkgconfig(mce)
+BuildRequires:  dbus
+%if %{with sdt}
+BuildRequires:  systemtap-sdt-devel
+%endif
 Requires: libglibutil >= 1.0.5
 Requires(post): /sbin/ldconfig
 Requires(postun): /sbin/ldconfig
@@ -28,7 +36,10 @@ This package contains the development library for %{name}.
 %setup -q
 
 %build
-make KEEP_SYMBOLS=1 release pkgconfig
+make KEEP_SYMBOLS=1 %{!?with_sdt:SDT=0} release pkgconfig
+
+%check
+make KEEP_SYMBOLS=1 %{!?with_sdt:SDT=0} check-sdt test
 
 %install
 rm -rf %{buildroot}
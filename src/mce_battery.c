@@ -0,0 +1,610 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_battery.h"
+#include "mce_defer.h"
+#include "mce_handler_p.h"
+#include "mce_proxy.h"
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+#include <gutil_misc.h>
+
+#include <stdlib.h>
+
+/* Generated headers */
+#include "com.nokia.mce.request.h"
+#include "com.nokia.mce.signal.h"
+
+enum mce_battery_known {
+    MCE_BATTERY_LEVEL_KNOWN = 0x01,
+    MCE_BATTERY_STATUS_KNOWN = 0x02,
+    MCE_BATTERY_ALL_KNOWN = 0x03
+};
+
+struct mce_battery_priv {
+    MceProxy* proxy;
+    gulong proxy_valid_id;
+    gulong battery_level_ind_id;
+    gulong battery_status_ind_id;
+    guint known;
+};
+
+/* Per-subscriber state of the rate-limited level handler */
+typedef struct mce_battery_limiter {
+    MceBattery* battery;
+    MceHandler* handler;
+    guint min_delta;
+    guint min_interval_ms;
+    gboolean notified;
+    guint last_level;
+    gint64 last_time;
+    guint timer_id;
+} MceBatteryLimiter;
+
+enum mce_battery_signal {
+    SIGNAL_VALID_CHANGED,
+    SIGNAL_LEVEL_CHANGED,
+    SIGNAL_STATUS_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_VALID_CHANGED_NAME   "mce-battery-valid-changed"
+#define SIGNAL_LEVEL_CHANGED_NAME   "mce-battery-level-changed"
+#define SIGNAL_STATUS_CHANGED_NAME  "mce-battery-status-changed"
+
+#define MCE_BATTERY_LEVEL_SIG "battery-level-ind"
+#define MCE_BATTERY_STATUS_SIG "battery-status-ind"
+#define MCE_BATTERY_GET_LEVEL "get_battery_level"
+#define MCE_BATTERY_GET_STATUS "get_battery_status"
+
+static guint mce_battery_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceBatteryClass;
+G_DEFINE_TYPE(MceBattery, mce_battery, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_battery_parent_class
+#define MCE_BATTERY_TYPE (mce_battery_get_type())
+#define MCE_BATTERY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_BATTERY_TYPE,MceBattery))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MCE_BATTERY_STATUS
+mce_battery_parse_status(
+    const char* status)
+{
+    if (!g_strcmp0(status, "ok")) {
+        return MCE_BATTERY_OK;
+    } else if (!g_strcmp0(status, "low")) {
+        return MCE_BATTERY_LOW;
+    } else if (!g_strcmp0(status, "empty")) {
+        return MCE_BATTERY_EMPTY;
+    } else if (!g_strcmp0(status, "full")) {
+        return MCE_BATTERY_FULL;
+    } else {
+        GASSERT(!g_strcmp0(status, "unknown"));
+        return MCE_BATTERY_UNKNOWN;
+    }
+}
+
+static
+void
+mce_battery_check_valid(
+    MceBattery* self)
+{
+    MceBatteryPriv* priv = self->priv;
+    const gboolean valid = priv->proxy->nokia_valid &&
+        priv->known == MCE_BATTERY_ALL_KNOWN;
+
+    if (self->valid != valid) {
+        self->valid = valid;
+        g_signal_emit(self, mce_battery_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_battery_level_update(
+    MceBattery* self,
+    gint32 level)
+{
+    MceBatteryPriv* priv = self->priv;
+    const guint value = CLAMP(level, 0, 100);
+
+    priv->known |= MCE_BATTERY_LEVEL_KNOWN;
+    if (self->level != value) {
+        self->level = value;
+        g_signal_emit(self, mce_battery_signals[SIGNAL_LEVEL_CHANGED], 0);
+    }
+    mce_battery_check_valid(self);
+}
+
+static
+void
+mce_battery_status_update(
+    MceBattery* self,
+    const char* status)
+{
+    MceBatteryPriv* priv = self->priv;
+    const MCE_BATTERY_STATUS value = mce_battery_parse_status(status);
+
+    priv->known |= MCE_BATTERY_STATUS_KNOWN;
+    if (self->status != value) {
+        self->status = value;
+        g_signal_emit(self, mce_battery_signals[SIGNAL_STATUS_CHANGED], 0);
+    }
+    mce_battery_check_valid(self);
+}
+
+static
+void
+mce_battery_level_query_done(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
+{
+    MceBattery* self = MCE_BATTERY(arg);
+
+    if (result) {
+        gint32 level = 0;
+
+        g_variant_get(result, "(i)", &level);
+        GDEBUG("Battery level is currently %d", level);
+        mce_battery_level_update(self, level);
+    } else {
+        /* battery_level_ind will eventually bring us in sync */
+        GWARN("Failed to query battery level %s", GERRMSG(error));
+    }
+    mce_battery_unref(self);
+}
+
+static
+void
+mce_battery_status_query_done(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
+{
+    MceBattery* self = MCE_BATTERY(arg);
+
+    if (result) {
+        const char* status = NULL;
+
+        g_variant_get(result, "(&s)", &status);
+        GDEBUG("Battery status is currently %s", status);
+        mce_battery_status_update(self, status);
+    } else {
+        GWARN("Failed to query battery status %s", GERRMSG(error));
+    }
+    mce_battery_unref(self);
+}
+
+static
+void
+mce_battery_level_ind(
+    ComNokiaMceSignal* proxy,
+    gint32 level,
+    gpointer arg)
+{
+    GDEBUG("Battery level is %d", level);
+    mce_battery_level_update(MCE_BATTERY(arg), level);
+}
+
+static
+void
+mce_battery_status_ind(
+    ComNokiaMceSignal* proxy,
+    const char* status,
+    gpointer arg)
+{
+    GDEBUG("Battery status is %s", status);
+    mce_battery_status_update(MCE_BATTERY(arg), status);
+}
+
+static
+void
+mce_battery_query(
+    MceBattery* self)
+{
+    MceBatteryPriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+
+    /* The same dance as in mce_display_status_query() */
+    if (proxy->nokia_signal && !priv->battery_level_ind_id) {
+        priv->battery_level_ind_id = g_signal_connect(proxy->nokia_signal,
+            MCE_BATTERY_LEVEL_SIG, G_CALLBACK(mce_battery_level_ind), self);
+        priv->battery_status_ind_id = g_signal_connect(proxy->nokia_signal,
+            MCE_BATTERY_STATUS_SIG, G_CALLBACK(mce_battery_status_ind), self);
+    }
+    if (proxy->nokia_request && proxy->nokia_valid) {
+        mce_proxy_call(proxy, proxy->nokia_request, MCE_BATTERY_GET_LEVEL,
+            NULL, G_VARIANT_TYPE("(i)"), mce_battery_level_query_done,
+            mce_battery_ref(self));
+        mce_proxy_call(proxy, proxy->nokia_request, MCE_BATTERY_GET_STATUS,
+            NULL, G_VARIANT_TYPE("(s)"), mce_battery_status_query_done,
+            mce_battery_ref(self));
+    }
+}
+
+static
+void
+mce_battery_valid_changed(
+    MceProxy* proxy,
+    void* arg)
+{
+    MceBattery* self = MCE_BATTERY(arg);
+
+    if (proxy->nokia_valid) {
+        mce_battery_query(self);
+    } else {
+        MceBatteryPriv* priv = self->priv;
+
+        /* The signal proxy may be replaced after reconnect */
+        if (priv->battery_level_ind_id) {
+            g_signal_handler_disconnect(proxy->nokia_signal,
+                priv->battery_level_ind_id);
+            g_signal_handler_disconnect(proxy->nokia_signal,
+                priv->battery_status_ind_id);
+            priv->battery_level_ind_id = 0;
+            priv->battery_status_ind_id = 0;
+        }
+        priv->known = 0;
+        mce_battery_check_valid(self);
+    }
+}
+
+static
+void
+mce_battery_limiter_notify(
+    MceBatteryLimiter* limiter)
+{
+    MceBattery* battery = limiter->battery;
+
+    limiter->notified = TRUE;
+    limiter->last_level = battery->level;
+    limiter->last_time = g_get_monotonic_time();
+    mce_handler_invoke(limiter->handler, G_OBJECT(battery));
+}
+
+static
+gboolean
+mce_battery_limiter_delta_reached(
+    MceBatteryLimiter* limiter)
+{
+    /* Even with no min_delta, the level has to be different */
+    return !limiter->notified || (guint)abs((int)limiter->battery->level -
+        (int)limiter->last_level) >= MAX(limiter->min_delta, 1);
+}
+
+static
+gboolean
+mce_battery_limiter_timeout(
+    gpointer data)
+{
+    MceBatteryLimiter* limiter = data;
+
+    limiter->timer_id = 0;
+    /* The level may have gone back in the meantime */
+    if (mce_battery_limiter_delta_reached(limiter)) {
+        mce_battery_limiter_notify(limiter);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_battery_limiter_level_changed(
+    MceBattery* battery,
+    gpointer data)
+{
+    MceBatteryLimiter* limiter = data;
+
+    if (!limiter->timer_id && mce_battery_limiter_delta_reached(limiter)) {
+        const gint64 next = limiter->last_time +
+            (gint64)limiter->min_interval_ms * 1000;
+        const gint64 now = g_get_monotonic_time();
+
+        if (!limiter->notified || now >= next) {
+            mce_battery_limiter_notify(limiter);
+        } else {
+            /* Deliver the latest level when the interval expires */
+            limiter->timer_id = g_timeout_add((guint)
+                ((next - now + 999) / 1000), mce_battery_limiter_timeout,
+                limiter);
+        }
+    }
+}
+
+static
+void
+mce_battery_limiter_free(
+    gpointer data,
+    GClosure* closure)
+{
+    MceBatteryLimiter* limiter = data;
+
+    if (limiter->timer_id) {
+        g_source_remove(limiter->timer_id);
+    }
+    mce_handler_free(limiter->handler);
+    g_slice_free(MceBatteryLimiter, limiter);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceBattery*
+mce_battery_new()
+{
+    /* MCE assumes one battery */
+    static MceBattery* mce_battery_instance = NULL;
+
+    if (mce_battery_instance) {
+        if (!mce_linger_revive(mce_battery_instance)) {
+            mce_battery_ref(mce_battery_instance);
+        }
+    } else {
+        MceBatteryPriv* priv;
+
+        mce_battery_instance = g_object_new(MCE_BATTERY_TYPE, NULL);
+        priv = mce_battery_instance->priv;
+        priv->proxy = mce_proxy_new();
+        priv->proxy_valid_id = mce_proxy_add_nokia_valid_changed_handler
+            (priv->proxy, mce_battery_valid_changed, mce_battery_instance);
+        mce_battery_query(mce_battery_instance);
+        g_object_add_weak_pointer(G_OBJECT(mce_battery_instance),
+            (gpointer*)(&mce_battery_instance));
+    }
+    return mce_battery_instance;
+}
+
+MceBattery*
+mce_battery_ref(
+    MceBattery* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_BATTERY(self));
+    }
+    return self;
+}
+
+void
+mce_battery_unref(
+    MceBattery* self)
+{
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
+        g_object_unref(MCE_BATTERY(self));
+    }
+}
+
+gulong
+mce_battery_add_valid_changed_handler(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_battery_add_level_changed_handler(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_LEVEL_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_battery_add_level_changed_handler_limited(
+    MceBattery* self,
+    guint min_delta,
+    guint min_interval_ms,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        if (min_delta || min_interval_ms) {
+            MceBatteryLimiter* limiter = g_slice_new0(MceBatteryLimiter);
+
+            /* The limiter is freed when the handler gets disconnected */
+            limiter->battery = self;
+            limiter->handler = mce_handler_new(SIGNAL_LEVEL_CHANGED_NAME,
+                G_CALLBACK(fn), arg);
+            limiter->min_delta = min_delta;
+            limiter->min_interval_ms = min_interval_ms;
+            if (self->valid) {
+                /* Count from the level the subscriber sees right now */
+                limiter->notified = TRUE;
+                limiter->last_level = self->level;
+                limiter->last_time = g_get_monotonic_time();
+            }
+            return g_signal_connect_data(self, SIGNAL_LEVEL_CHANGED_NAME,
+                G_CALLBACK(mce_battery_limiter_level_changed), limiter,
+                mce_battery_limiter_free, 0);
+        } else {
+            return mce_battery_add_level_changed_handler(self, fn, arg);
+        }
+    }
+    return 0;
+}
+
+gulong
+mce_battery_add_status_changed_handler(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_STATUS_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_battery_add_valid_changed_handler_full(
+    MceBattery* self,
+    MCE_PRIORITY priority,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_battery_add_valid_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_battery_add_level_changed_handler_full(
+    MceBattery* self,
+    MCE_PRIORITY priority,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_LEVEL_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_battery_add_level_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_battery_add_status_changed_handler_full(
+    MceBattery* self,
+    MCE_PRIORITY priority,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_STATUS_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_battery_add_status_changed_handler(self, fn, arg);
+    }
+}
+
+void
+mce_battery_remove_handler(
+    MceBattery* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        g_signal_handler_disconnect(self, id);
+    }
+}
+
+void
+mce_battery_remove_handlers(
+    MceBattery* self,
+    gulong *ids,
+    guint count)
+{
+    gutil_disconnect_handlers(self, ids, count);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_battery_init(
+    MceBattery* self)
+{
+    MceBatteryPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_BATTERY_TYPE,
+        MceBatteryPriv);
+
+    self->priv = priv;
+}
+
+static
+void
+mce_battery_finalize(
+    GObject* object)
+{
+    MceBattery* self = MCE_BATTERY(object);
+    MceBatteryPriv* priv = self->priv;
+
+    if (priv->battery_level_ind_id) {
+        g_signal_handler_disconnect(priv->proxy->nokia_signal,
+            priv->battery_level_ind_id);
+        g_signal_handler_disconnect(priv->proxy->nokia_signal,
+            priv->battery_status_ind_id);
+    }
+    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    mce_proxy_unref(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_battery_class_init(
+    MceBatteryClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_battery_finalize;
+    g_type_class_add_private(klass, sizeof(MceBatteryPriv));
+    mce_battery_signals[SIGNAL_VALID_CHANGED] =
+        g_signal_new(SIGNAL_VALID_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_battery_signals[SIGNAL_LEVEL_CHANGED] =
+        g_signal_new(SIGNAL_LEVEL_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_battery_signals[SIGNAL_STATUS_CHANGED] =
+        g_signal_new(SIGNAL_STATUS_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
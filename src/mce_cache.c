@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_cache_p.h"
+#include "mce_log_p.h"
+
+#include <sys/stat.h>
+#include <time.h>
+
+#define MCE_CACHE_DIR "mce-glib"
+#define MCE_CACHE_FILE "state"
+#define MCE_CACHE_GROUP "State"
+#define MCE_CACHE_TIME_SUFFIX "-time"
+#define MCE_CACHE_SAVE_DELAY_MS (1000)
+
+static gboolean mce_cache_on = FALSE;
+static GKeyFile* mce_cache_data = NULL;
+static guint mce_cache_save_id = 0;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+char*
+mce_cache_path(
+    void)
+{
+    return g_build_filename(g_get_user_runtime_dir(), MCE_CACHE_DIR,
+        MCE_CACHE_FILE, NULL);
+}
+
+static
+GKeyFile*
+mce_cache_load(
+    void)
+{
+    if (!mce_cache_data) {
+        char* path = mce_cache_path();
+
+        /* A missing file is fine, it will be created on the next update */
+        mce_cache_data = g_key_file_new();
+        if (g_key_file_load_from_file(mce_cache_data, path, 0, NULL)) {
+            GDEBUG("Loaded %s", path);
+        }
+        g_free(path);
+    }
+    return mce_cache_data;
+}
+
+static
+void
+mce_cache_save(
+    GKeyFile* data)
+{
+    char* path = mce_cache_path();
+    char* dir = g_path_get_dirname(path);
+    gsize len = 0;
+    char* contents = g_key_file_to_data(data, &len, NULL);
+    GError* error = NULL;
+
+    /* g_file_set_contents() writes a temporary file and renames it */
+    if (g_mkdir_with_parents(dir, S_IRWXU) < 0 ||
+        !g_file_set_contents(path, contents, len, &error)) {
+        GWARN("Failed to update %s: %s", path, error ? GERRMSG(error) :
+            "can't create directory");
+        if (error) {
+            g_error_free(error);
+        }
+    }
+    g_free(contents);
+    g_free(dir);
+    g_free(path);
+}
+
+static
+gboolean
+mce_cache_save_cb(
+    gpointer arg)
+{
+    mce_cache_save_id = 0;
+    mce_cache_save(mce_cache_data);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gint64
+mce_cache_boot_time(
+    void)
+{
+    struct timespec ts;
+
+    /* Wall clock time of the boot, in microseconds */
+    if (!clock_gettime(CLOCK_BOOTTIME, &ts)) {
+        return g_get_real_time() - (((gint64)ts.tv_sec) * G_USEC_PER_SEC +
+            ts.tv_nsec / 1000);
+    }
+    return 0;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gboolean
+mce_cache_get(
+    const char* key,
+    int min,
+    int max,
+    int* value)
+{
+    gboolean found = FALSE;
+
+    if (mce_cache_on) {
+        GKeyFile* data = mce_cache_load();
+
+        if (g_key_file_has_key(data, MCE_CACHE_GROUP, key, NULL)) {
+            char* time_key = g_strconcat(key, MCE_CACHE_TIME_SUFFIX, NULL);
+            const gint64 time = g_key_file_get_int64(data, MCE_CACHE_GROUP,
+                time_key, NULL);
+
+            /*
+             * If the runtime directory isn't tmpfs, the file survives
+             * reboots. Whatever was stored before the boot is garbage,
+             * allowing a second of slack for the clock jitter.
+             */
+            if (time + G_USEC_PER_SEC < mce_cache_boot_time()) {
+                GDEBUG("Ignoring stale %s", key);
+            } else {
+                GError* error = NULL;
+                const int v = g_key_file_get_integer(data, MCE_CACHE_GROUP,
+                    key, &error);
+
+                /*
+                 * The file may have been written by a different version
+                 * of the library, or by someone else altogether. Don't
+                 * let the garbage into the enums.
+                 */
+                if (error || v < min || v > max) {
+                    GWARN("Discarding bad %s", key);
+                    g_key_file_remove_key(data, MCE_CACHE_GROUP, key, NULL);
+                    g_key_file_remove_key(data, MCE_CACHE_GROUP, time_key,
+                        NULL);
+                    if (error) {
+                        g_error_free(error);
+                    }
+                } else {
+                    *value = v;
+                    found = TRUE;
+                }
+            }
+            g_free(time_key);
+        }
+    }
+    return found;
+}
+
+void
+mce_cache_set(
+    const char* key,
+    int value)
+{
+    if (mce_cache_on) {
+        GKeyFile* data = mce_cache_load();
+        char* time_key = g_strconcat(key, MCE_CACHE_TIME_SUFFIX, NULL);
+
+        g_key_file_set_integer(data, MCE_CACHE_GROUP, key, value);
+        g_key_file_set_int64(data, MCE_CACHE_GROUP, time_key,
+            g_get_real_time());
+        g_free(time_key);
+
+        /* Coalesce the bursts of transitions into a single write */
+        if (!mce_cache_save_id) {
+            mce_cache_save_id = g_timeout_add(MCE_CACHE_SAVE_DELAY_MS,
+                mce_cache_save_cb, NULL);
+        }
+    }
+}
+
+void
+mce_cache_flush(
+    void)
+{
+    if (mce_cache_save_id) {
+        g_source_remove(mce_cache_save_id);
+        mce_cache_save_id = 0;
+        mce_cache_save(mce_cache_data);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+mce_cache_set_enabled(
+    gboolean enabled)
+{
+    if (!enabled) {
+        mce_cache_flush();
+    }
+    mce_cache_on = enabled;
+}
+
+gboolean
+mce_cache_enabled(
+    void)
+{
+    return mce_cache_on;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_call_state.h"
+#include "mce_defer.h"
+#include "mce_handler_p.h"
+#include "mce_proxy.h"
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+#include <gutil_misc.h>
+
+/* Generated headers */
+#include "com.nokia.mce.request.h"
+#include "com.nokia.mce.signal.h"
+
+struct mce_call_state_priv {
+    MceProxy* proxy;
+    gulong proxy_valid_id;
+    gulong call_state_ind_id;
+};
+
+enum mce_call_state_signal {
+    SIGNAL_VALID_CHANGED,
+    SIGNAL_STATE_CHANGED,
+    SIGNAL_TYPE_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_VALID_CHANGED_NAME   "mce-call-state-valid-changed"
+#define SIGNAL_STATE_CHANGED_NAME   "mce-call-state-state-changed"
+#define SIGNAL_TYPE_CHANGED_NAME    "mce-call-state-type-changed"
+
+#define MCE_CALL_STATE_SIG "sig-call-state-ind"
+#define MCE_CALL_STATE_GET "get_call_state"
+
+static guint mce_call_state_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceCallStateClass;
+G_DEFINE_TYPE(MceCallState, mce_call_state, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_call_state_parent_class
+#define MCE_CALL_STATE_TYPE (mce_call_state_get_type())
+#define MCE_CALL_STATE(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_CALL_STATE_TYPE,MceCallState))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MCE_CALL_STATE_STATE
+mce_call_state_parse_state(
+    const char* state)
+{
+    if (!g_strcmp0(state, "ringing")) {
+        return MCE_CALL_STATE_RINGING;
+    } else if (!g_strcmp0(state, "active")) {
+        return MCE_CALL_STATE_ACTIVE;
+    } else if (!g_strcmp0(state, "service")) {
+        return MCE_CALL_STATE_SERVICE;
+    } else {
+        return MCE_CALL_STATE_NONE;
+    }
+}
+
+static
+MCE_CALL_TYPE
+mce_call_state_parse_type(
+    const char* type)
+{
+    return g_strcmp0(type, "emergency") ? MCE_CALL_TYPE_NORMAL :
+        MCE_CALL_TYPE_EMERGENCY;
+}
+
+static
+void
+mce_call_state_update(
+    MceCallState* self,
+    const char* state,
+    const char* type)
+{
+    const MCE_CALL_STATE_STATE new_state = mce_call_state_parse_state(state);
+    const MCE_CALL_TYPE new_type = mce_call_state_parse_type(type);
+    MceCallStatePriv* priv = self->priv;
+    gboolean state_changed = FALSE, type_changed = FALSE;
+
+    /* Update both fields before emitting anything */
+    if (self->state != new_state) {
+        self->state = new_state;
+        state_changed = TRUE;
+    }
+    if (self->type != new_type) {
+        self->type = new_type;
+        type_changed = TRUE;
+    }
+    if (state_changed) {
+        g_signal_emit(self, mce_call_state_signals[SIGNAL_STATE_CHANGED], 0);
+    }
+    if (type_changed) {
+        g_signal_emit(self, mce_call_state_signals[SIGNAL_TYPE_CHANGED], 0);
+    }
+    if (priv->proxy->nokia_valid && !self->valid) {
+        self->valid = TRUE;
+        g_signal_emit(self, mce_call_state_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_call_state_query_done(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
+{
+    MceCallState* self = MCE_CALL_STATE(arg);
+
+    if (result) {
+        const char* state = NULL;
+        const char* type = NULL;
+
+        g_variant_get(result, "(&s&s)", &state, &type);
+        GDEBUG("Call is currently %s (%s)", state, type);
+        mce_call_state_update(self, state, type);
+    } else {
+        /* sig_call_state_ind will eventually bring us in sync */
+        GWARN("Failed to query call state %s", GERRMSG(error));
+    }
+    mce_call_state_unref(self);
+}
+
+static
+void
+mce_call_state_ind(
+    ComNokiaMceSignal* proxy,
+    const char* state,
+    const char* type,
+    gpointer arg)
+{
+    GDEBUG("Call is %s (%s)", state, type);
+    mce_call_state_update(MCE_CALL_STATE(arg), state, type);
+}
+
+static
+void
+mce_call_state_query(
+    MceCallState* self)
+{
+    MceCallStatePriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+
+    /*
+     * The state is only queried once when mce shows up, after that
+     * the cached value is kept up to date by the signal alone.
+     */
+    if (proxy->nokia_signal && !priv->call_state_ind_id) {
+        priv->call_state_ind_id = g_signal_connect(proxy->nokia_signal,
+            MCE_CALL_STATE_SIG, G_CALLBACK(mce_call_state_ind), self);
+    }
+    if (proxy->nokia_request && proxy->nokia_valid) {
+        mce_proxy_call(proxy, proxy->nokia_request, MCE_CALL_STATE_GET,
+            NULL, G_VARIANT_TYPE("(ss)"), mce_call_state_query_done,
+            mce_call_state_ref(self));
+    }
+}
+
+static
+void
+mce_call_state_valid_changed(
+    MceProxy* proxy,
+    void* arg)
+{
+    MceCallState* self = MCE_CALL_STATE(arg);
+
+    if (proxy->nokia_valid) {
+        mce_call_state_query(self);
+    } else {
+        MceCallStatePriv* priv = self->priv;
+
+        /* The signal proxy may be replaced after reconnect */
+        if (priv->call_state_ind_id) {
+            g_signal_handler_disconnect(proxy->nokia_signal,
+                priv->call_state_ind_id);
+            priv->call_state_ind_id = 0;
+        }
+        if (self->valid) {
+            self->valid = FALSE;
+            g_signal_emit(self,
+                mce_call_state_signals[SIGNAL_VALID_CHANGED], 0);
+        }
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceCallState*
+mce_call_state_new()
+{
+    static MceCallState* mce_call_state_instance = NULL;
+
+    if (mce_call_state_instance) {
+        if (!mce_linger_revive(mce_call_state_instance)) {
+            mce_call_state_ref(mce_call_state_instance);
+        }
+    } else {
+        MceCallStatePriv* priv;
+
+        mce_call_state_instance = g_object_new(MCE_CALL_STATE_TYPE, NULL);
+        priv = mce_call_state_instance->priv;
+        priv->proxy = mce_proxy_new();
+        priv->proxy_valid_id = mce_proxy_add_nokia_valid_changed_handler
+            (priv->proxy, mce_call_state_valid_changed,
+                mce_call_state_instance);
+        mce_call_state_query(mce_call_state_instance);
+        g_object_add_weak_pointer(G_OBJECT(mce_call_state_instance),
+            (gpointer*)(&mce_call_state_instance));
+    }
+    return mce_call_state_instance;
+}
+
+MceCallState*
+mce_call_state_ref(
+    MceCallState* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_CALL_STATE(self));
+    }
+    return self;
+}
+
+void
+mce_call_state_unref(
+    MceCallState* self)
+{
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
+        g_object_unref(MCE_CALL_STATE(self));
+    }
+}
+
+gulong
+mce_call_state_add_valid_changed_handler(
+    MceCallState* self,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_call_state_add_state_changed_handler(
+    MceCallState* self,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_call_state_add_type_changed_handler(
+    MceCallState* self,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_TYPE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_call_state_add_valid_changed_handler_full(
+    MceCallState* self,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_call_state_add_valid_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_call_state_add_state_changed_handler_full(
+    MceCallState* self,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_call_state_add_state_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_call_state_add_type_changed_handler_full(
+    MceCallState* self,
+    MCE_PRIORITY priority,
+    MceCallStateFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_TYPE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_call_state_add_type_changed_handler(self, fn, arg);
+    }
+}
+
+void
+mce_call_state_remove_handler(
+    MceCallState* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        g_signal_handler_disconnect(self, id);
+    }
+}
+
+void
+mce_call_state_remove_handlers(
+    MceCallState* self,
+    gulong *ids,
+    guint count)
+{
+    gutil_disconnect_handlers(self, ids, count);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_call_state_init(
+    MceCallState* self)
+{
+    MceCallStatePriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self,
+        MCE_CALL_STATE_TYPE, MceCallStatePriv);
+
+    self->priv = priv;
+}
+
+static
+void
+mce_call_state_finalize(
+    GObject* object)
+{
+    MceCallState* self = MCE_CALL_STATE(object);
+    MceCallStatePriv* priv = self->priv;
+
+    if (priv->call_state_ind_id) {
+        g_signal_handler_disconnect(priv->proxy->nokia_signal,
+            priv->call_state_ind_id);
+    }
+    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    mce_proxy_unref(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_call_state_class_init(
+    MceCallStateClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_call_state_finalize;
+    g_type_class_add_private(klass, sizeof(MceCallStatePriv));
+    mce_call_state_signals[SIGNAL_VALID_CHANGED] =
+        g_signal_new(SIGNAL_VALID_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_call_state_signals[SIGNAL_STATE_CHANGED] =
+        g_signal_new(SIGNAL_STATE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_call_state_signals[SIGNAL_TYPE_CHANGED] =
+        g_signal_new(SIGNAL_TYPE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_charger.h"
+#include "mce_defer.h"
+#include "mce_handler_p.h"
+#include "mce_proxy.h"
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+#include <gutil_misc.h>
+
+/* Generated headers */
+#include "com.nokia.mce.request.h"
+#include "com.nokia.mce.signal.h"
+
+struct mce_charger_priv {
+    MceProxy* proxy;
+    gulong proxy_valid_id;
+    gulong charger_state_ind_id;
+};
+
+enum mce_charger_signal {
+    SIGNAL_VALID_CHANGED,
+    SIGNAL_STATE_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_VALID_CHANGED_NAME   "mce-charger-valid-changed"
+#define SIGNAL_STATE_CHANGED_NAME   "mce-charger-state-changed"
+
+#define MCE_CHARGER_STATE_SIG "charger-state-ind"
+#define MCE_CHARGER_GET_STATE "get_charger_state"
+
+static guint mce_charger_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceChargerClass;
+G_DEFINE_TYPE(MceCharger, mce_charger, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_charger_parent_class
+#define MCE_CHARGER_TYPE (mce_charger_get_type())
+#define MCE_CHARGER(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_CHARGER_TYPE,MceCharger))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MCE_CHARGER_STATE
+mce_charger_parse_state(
+    const char* state)
+{
+    if (!g_strcmp0(state, "on")) {
+        return MCE_CHARGER_ON;
+    } else if (!g_strcmp0(state, "off")) {
+        return MCE_CHARGER_OFF;
+    } else {
+        GASSERT(!g_strcmp0(state, "unknown"));
+        return MCE_CHARGER_UNKNOWN;
+    }
+}
+
+static
+void
+mce_charger_state_update(
+    MceCharger* self,
+    const char* state)
+{
+    const MCE_CHARGER_STATE value = mce_charger_parse_state(state);
+    MceChargerPriv* priv = self->priv;
+
+    if (self->state != value) {
+        self->state = value;
+        g_signal_emit(self, mce_charger_signals[SIGNAL_STATE_CHANGED], 0);
+    }
+    if (priv->proxy->nokia_valid && !self->valid) {
+        self->valid = TRUE;
+        g_signal_emit(self, mce_charger_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_charger_state_query_done(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
+{
+    MceCharger* self = MCE_CHARGER(arg);
+
+    if (result) {
+        const char* state = NULL;
+
+        g_variant_get(result, "(&s)", &state);
+        GDEBUG("Charger is currently %s", state);
+        mce_charger_state_update(self, state);
+    } else {
+        /* charger_state_ind will eventually bring us in sync */
+        GWARN("Failed to query charger state %s", GERRMSG(error));
+    }
+    mce_charger_unref(self);
+}
+
+static
+void
+mce_charger_state_ind(
+    ComNokiaMceSignal* proxy,
+    const char* state,
+    gpointer arg)
+{
+    GDEBUG("Charger is %s", state);
+    mce_charger_state_update(MCE_CHARGER(arg), state);
+}
+
+static
+void
+mce_charger_state_query(
+    MceCharger* self)
+{
+    MceChargerPriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+
+    if (proxy->nokia_signal && !priv->charger_state_ind_id) {
+        priv->charger_state_ind_id = g_signal_connect(proxy->nokia_signal,
+            MCE_CHARGER_STATE_SIG, G_CALLBACK(mce_charger_state_ind), self);
+    }
+    if (proxy->nokia_request && proxy->nokia_valid) {
+        mce_proxy_call(proxy, proxy->nokia_request, MCE_CHARGER_GET_STATE,
+            NULL, G_VARIANT_TYPE("(s)"), mce_charger_state_query_done,
+            mce_charger_ref(self));
+    }
+}
+
+static
+void
+mce_charger_valid_changed(
+    MceProxy* proxy,
+    void* arg)
+{
+    MceCharger* self = MCE_CHARGER(arg);
+
+    if (proxy->nokia_valid) {
+        mce_charger_state_query(self);
+    } else {
+        MceChargerPriv* priv = self->priv;
+
+        /* The signal proxy may be replaced after reconnect */
+        if (priv->charger_state_ind_id) {
+            g_signal_handler_disconnect(proxy->nokia_signal,
+                priv->charger_state_ind_id);
+            priv->charger_state_ind_id = 0;
+        }
+        if (self->valid) {
+            self->valid = FALSE;
+            g_signal_emit(self, mce_charger_signals[SIGNAL_VALID_CHANGED], 0);
+        }
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceCharger*
+mce_charger_new()
+{
+    static MceCharger* mce_charger_instance = NULL;
+
+    if (mce_charger_instance) {
+        if (!mce_linger_revive(mce_charger_instance)) {
+            mce_charger_ref(mce_charger_instance);
+        }
+    } else {
+        MceChargerPriv* priv;
+
+        mce_charger_instance = g_object_new(MCE_CHARGER_TYPE, NULL);
+        priv = mce_charger_instance->priv;
+        priv->proxy = mce_proxy_new();
+        priv->proxy_valid_id = mce_proxy_add_nokia_valid_changed_handler
+            (priv->proxy, mce_charger_valid_changed, mce_charger_instance);
+        mce_charger_state_query(mce_charger_instance);
+        g_object_add_weak_pointer(G_OBJECT(mce_charger_instance),
+            (gpointer*)(&mce_charger_instance));
+    }
+    return mce_charger_instance;
+}
+
+MceCharger*
+mce_charger_ref(
+    MceCharger* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_CHARGER(self));
+    }
+    return self;
+}
+
+void
+mce_charger_unref(
+    MceCharger* self)
+{
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
+        g_object_unref(MCE_CHARGER(self));
+    }
+}
+
+gulong
+mce_charger_add_valid_changed_handler(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_charger_add_state_changed_handler(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_charger_add_valid_changed_handler_full(
+    MceCharger* self,
+    MCE_PRIORITY priority,
+    MceChargerFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_charger_add_valid_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_charger_add_state_changed_handler_full(
+    MceCharger* self,
+    MCE_PRIORITY priority,
+    MceChargerFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_charger_add_state_changed_handler(self, fn, arg);
+    }
+}
+
+void
+mce_charger_remove_handler(
+    MceCharger* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        g_signal_handler_disconnect(self, id);
+    }
+}
+
+void
+mce_charger_remove_handlers(
+    MceCharger* self,
+    gulong *ids,
+    guint count)
+{
+    gutil_disconnect_handlers(self, ids, count);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_charger_init(
+    MceCharger* self)
+{
+    MceChargerPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_CHARGER_TYPE,
+        MceChargerPriv);
+
+    self->priv = priv;
+}
+
+static
+void
+mce_charger_finalize(
+    GObject* object)
+{
+    MceCharger* self = MCE_CHARGER(object);
+    MceChargerPriv* priv = self->priv;
+
+    if (priv->charger_state_ind_id) {
+        g_signal_handler_disconnect(priv->proxy->nokia_signal,
+            priv->charger_state_ind_id);
+    }
+    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    mce_proxy_unref(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_charger_class_init(
+    MceChargerClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_charger_finalize;
+    g_type_class_add_private(klass, sizeof(MceChargerPriv));
+    mce_charger_signals[SIGNAL_VALID_CHANGED] =
+        g_signal_new(SIGNAL_VALID_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_charger_signals[SIGNAL_STATE_CHANGED] =
+        g_signal_new(SIGNAL_STATE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_defer.h"
+#include "mce_display.h"
+#include "mce_handler_p.h"
+#include "mce_log_p.h"
+
+typedef struct mce_defer_sub {
+    gint ref_count;
+    GObject* object;
+    MceDisplay* display;
+    MceHandler* handler;
+    gboolean pending;
+    gboolean removed;
+} MceDeferSub;
+
+enum mce_defer_display_events {
+    DISPLAY_EVENT_VALID,
+    DISPLAY_EVENT_STATE,
+    DISPLAY_EVENT_COUNT
+};
+
+/*
+ * All deferrable handlers in the order of registration. The display
+ * pointer is weak, the display is kept alive by the handlers of the
+ * other objects (and by its owner).
+ */
+static GSList* mce_defer_subs = NULL;
+static MceDisplay* mce_defer_display = NULL;
+static gulong mce_defer_display_event_id[DISPLAY_EVENT_COUNT];
+
+static
+gboolean
+mce_defer_active(
+    void)
+{
+    MceDisplay* display = mce_defer_display;
+
+    return display && display->valid &&
+        display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+mce_defer_sub_unref(
+    MceDeferSub* sub)
+{
+    if (!--sub->ref_count) {
+        mce_handler_free(sub->handler);
+        g_slice_free(MceDeferSub, sub);
+    }
+}
+
+static
+void
+mce_defer_flush(
+    MceDisplay* display,
+    void* arg)
+{
+    if (!mce_defer_active()) {
+        GSList* pending = NULL;
+        GSList* l;
+
+        for (l = mce_defer_subs; l; l = l->next) {
+            MceDeferSub* sub = l->data;
+
+            if (sub->pending) {
+                sub->pending = FALSE;
+                sub->ref_count++;
+                g_object_ref(sub->object);
+                pending = g_slist_prepend(pending, sub);
+            }
+        }
+
+        if (pending) {
+            GDEBUG("Flushing %u deferred handler(s)", g_slist_length(pending));
+            pending = g_slist_reverse(pending);
+            for (l = pending; l; l = l->next) {
+                MceDeferSub* sub = l->data;
+                GObject* object = sub->object;
+
+                /* Handlers may remove other handlers */
+                if (!sub->removed) {
+                    mce_handler_invoke(sub->handler, object);
+                }
+                mce_defer_sub_unref(sub);
+                g_object_unref(object);
+            }
+            g_slist_free(pending);
+        }
+    }
+}
+
+static
+void
+mce_defer_signal(
+    GObject* object,
+    gpointer data)
+{
+    MceDeferSub* sub = data;
+
+    if (mce_defer_active()) {
+        sub->pending = TRUE;
+    } else {
+        sub->pending = FALSE;
+        mce_handler_invoke(sub->handler, object);
+    }
+}
+
+static
+void
+mce_defer_sub_destroy(
+    gpointer data,
+    GClosure* closure)
+{
+    MceDeferSub* sub = data;
+
+    sub->removed = TRUE;
+    mce_defer_subs = g_slist_remove(mce_defer_subs, sub);
+    if (!mce_defer_subs && mce_defer_display) {
+        MceDisplay* display = mce_defer_display;
+        int i;
+
+        /* The display may be in the middle of being disposed */
+        for (i = 0; i < DISPLAY_EVENT_COUNT; i++) {
+            if (g_signal_handler_is_connected(display,
+                mce_defer_display_event_id[i])) {
+                g_signal_handler_disconnect(display,
+                    mce_defer_display_event_id[i]);
+            }
+            mce_defer_display_event_id[i] = 0;
+        }
+        g_object_remove_weak_pointer(G_OBJECT(display),
+            (gpointer*)&mce_defer_display);
+        mce_defer_display = NULL;
+    }
+    if (sub->display) {
+        mce_display_unref(sub->display);
+    }
+    mce_defer_sub_unref(sub);
+}
+
+gulong
+mce_defer_connect(
+    gpointer object,
+    const char* signal,
+    GCallback fn,
+    void* arg)
+{
+    MceDeferSub* sub = g_slice_new0(MceDeferSub);
+    MceDisplay* display = mce_display_new();
+
+    if (!mce_defer_display) {
+        /*
+         * Flush handlers run after all other handlers. That way the
+         * handlers of the display itself are invoked only once when
+         * it turns on.
+         */
+        mce_defer_display = display;
+        g_object_add_weak_pointer(G_OBJECT(display),
+            (gpointer*)&mce_defer_display);
+        mce_defer_display_event_id[DISPLAY_EVENT_VALID] =
+            g_signal_connect_after(mce_defer_display,
+                "mce-display-valid-changed",
+                G_CALLBACK(mce_defer_flush), NULL);
+        mce_defer_display_event_id[DISPLAY_EVENT_STATE] =
+            g_signal_connect_after(mce_defer_display,
+                "mce-display-state-changed",
+                G_CALLBACK(mce_defer_flush), NULL);
+    }
+
+    /*
+     * Handlers of other objects keep the display alive, or they would
+     * never be deferred. Handlers of the display itself don't, or the
+     * display would keep itself alive.
+     */
+    if (object == (gpointer)display) {
+        mce_display_unref(display);
+    } else {
+        sub->display = display;
+    }
+    sub->ref_count = 1;
+    sub->object = object;
+    sub->handler = mce_handler_new(signal, fn, arg);
+    mce_defer_subs = g_slist_append(mce_defer_subs, sub);
+    return g_signal_connect_data(object, signal,
+        G_CALLBACK(mce_defer_signal), sub, mce_defer_sub_destroy, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
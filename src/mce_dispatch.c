@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_dispatch.h"
+#include "mce_handler_p.h"
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+typedef struct mce_dispatch_ctx {
+    gint ref_count;
+    GObject* object;
+    GWeakRef object_ref;
+    GMainContext* context;
+    GSource* source;
+    GSList* subs;
+} MceDispatchCtx;
+
+typedef struct mce_dispatch_sub {
+    gint ref_count;
+    MceDispatchCtx* ctx;
+    MceHandler* handler;
+    gboolean pending;
+    gboolean removed;
+} MceDispatchSub;
+
+/* Protects everything in this file */
+G_LOCK_DEFINE_STATIC(mce_dispatch);
+static GSList* mce_dispatch_contexts = NULL;
+
+static
+MceDispatchCtx*
+mce_dispatch_ctx_ref(
+    MceDispatchCtx* ctx)
+{
+    g_atomic_int_inc(&ctx->ref_count);
+    return ctx;
+}
+
+static
+void
+mce_dispatch_ctx_unref(
+    gpointer data)
+{
+    MceDispatchCtx* ctx = data;
+
+    if (g_atomic_int_dec_and_test(&ctx->ref_count)) {
+        GASSERT(!ctx->subs);
+        GASSERT(!ctx->source);
+        g_weak_ref_clear(&ctx->object_ref);
+        g_main_context_unref(ctx->context);
+        g_slice_free(MceDispatchCtx, ctx);
+    }
+}
+
+static
+void
+mce_dispatch_sub_unref(
+    MceDispatchSub* sub)
+{
+    if (g_atomic_int_dec_and_test(&sub->ref_count)) {
+        mce_handler_free(sub->handler);
+        g_slice_free(MceDispatchSub, sub);
+    }
+}
+
+static
+gboolean
+mce_dispatch_object_release(
+    gpointer object)
+{
+    /* Same as what the _unref() functions do */
+    if (!mce_linger_unref(object)) {
+        g_object_unref(object);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+mce_dispatch_ctx_run(
+    gpointer data)
+{
+    MceDispatchCtx* ctx = data;
+    GObject* object = g_weak_ref_get(&ctx->object_ref);
+    GSList* subs = NULL;
+    GSList* l;
+
+    /* Collect pending handlers */
+    G_LOCK(mce_dispatch);
+    g_source_unref(ctx->source);
+    ctx->source = NULL;
+    for (l = ctx->subs; l; l = l->next) {
+        MceDispatchSub* sub = l->data;
+
+        if (sub->pending) {
+            sub->pending = FALSE;
+            if (object) {
+                g_atomic_int_inc(&sub->ref_count);
+                subs = g_slist_prepend(subs, sub);
+            }
+        }
+    }
+    G_UNLOCK(mce_dispatch);
+
+    /* Invoke them without holding the lock */
+    subs = g_slist_reverse(subs);
+    for (l = subs; l; l = l->next) {
+        MceDispatchSub* sub = l->data;
+
+        if (!g_atomic_int_get(&sub->removed)) {
+            mce_handler_invoke(sub->handler, object);
+        }
+        mce_dispatch_sub_unref(sub);
+    }
+    g_slist_free(subs);
+
+    /*
+     * If the owner has let go of the object in the meantime, ours may
+     * be the last reference. Finalizing the object (or letting it
+     * linger) is the business of the context it belongs to.
+     */
+    if (object) {
+        g_main_context_invoke(NULL, mce_dispatch_object_release, object);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_dispatch_signal(
+    GObject* object,
+    gpointer data)
+{
+    MceDispatchSub* sub = data;
+    MceDispatchCtx* ctx = sub->ctx;
+
+    G_LOCK(mce_dispatch);
+    sub->pending = TRUE;
+    if (!ctx->source) {
+        /* One wakeup per context no matter how many handlers */
+        ctx->source = g_idle_source_new();
+        g_source_set_priority(ctx->source, G_PRIORITY_DEFAULT);
+        g_source_set_callback(ctx->source, mce_dispatch_ctx_run,
+            mce_dispatch_ctx_ref(ctx), mce_dispatch_ctx_unref);
+        g_source_attach(ctx->source, ctx->context);
+    }
+    G_UNLOCK(mce_dispatch);
+}
+
+static
+void
+mce_dispatch_sub_destroy(
+    gpointer data,
+    GClosure* closure)
+{
+    MceDispatchSub* sub = data;
+    MceDispatchCtx* ctx = sub->ctx;
+
+    G_LOCK(mce_dispatch);
+    g_atomic_int_set(&sub->removed, TRUE);
+    ctx->subs = g_slist_remove(ctx->subs, sub);
+    if (!ctx->subs) {
+        mce_dispatch_contexts = g_slist_remove(mce_dispatch_contexts, ctx);
+    } else {
+        ctx = NULL;
+    }
+    G_UNLOCK(mce_dispatch);
+
+    if (ctx) {
+        mce_dispatch_ctx_unref(ctx);
+    }
+    mce_dispatch_sub_unref(sub);
+}
+
+gulong
+mce_dispatch_connect(
+    gpointer object,
+    const char* signal,
+    GCallback fn,
+    void* arg)
+{
+    GMainContext* context = g_main_context_ref_thread_default();
+    MceDispatchSub* sub = g_slice_new0(MceDispatchSub);
+    MceDispatchCtx* ctx = NULL;
+    GSList* l;
+
+    sub->ref_count = 1;
+    sub->handler = mce_handler_new(signal, fn, arg);
+
+    G_LOCK(mce_dispatch);
+    for (l = mce_dispatch_contexts; l && !ctx; l = l->next) {
+        MceDispatchCtx* c = l->data;
+
+        if (c->object == object && c->context == context) {
+            ctx = c;
+        }
+    }
+    if (!ctx) {
+        ctx = g_slice_new0(MceDispatchCtx);
+        ctx->ref_count = 1;
+        ctx->object = object;
+        g_weak_ref_init(&ctx->object_ref, object);
+        ctx->context = g_main_context_ref(context);
+        mce_dispatch_contexts = g_slist_prepend(mce_dispatch_contexts, ctx);
+    }
+    sub->ctx = ctx;
+    ctx->subs = g_slist_append(ctx->subs, sub);
+    G_UNLOCK(mce_dispatch);
+
+    g_main_context_unref(context);
+    return g_signal_connect_data(object, signal,
+        G_CALLBACK(mce_dispatch_signal), sub, mce_dispatch_sub_destroy, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
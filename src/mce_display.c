@@ -36,17 +36,30 @@
 
 #include "mce_display.h"
 #include "mce_proxy.h"
+#include "mce_defer.h"
+#include "mce_dispatch.h"
+#include "mce_shm_p.h"
+#include "mce_cache_p.h"
+#include "mce_handler_p.h"
+#include "mce_trace_p.h"
+#include "mce_linger_p.h"
 #include "mce_log_p.h"
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.canonical.Unity.Screen.h"
+typedef struct mce_display_waiter {
+    MceDisplayFreshFunc fn;
+    void* arg;
+} MceDisplayWaiter;
 
 struct mce_display_priv {
+    MceShm* shm;
     MceProxy* proxy;
     gulong proxy_valid_id;
-    gulong display_status_ind_id;
+    guint display_status_ind_id;
+    gint64 confirmed;
+    guint queries;
+    GSList* waiters;
 };
 
 enum mce_display_signal {
@@ -61,8 +74,6 @@ enum mce_display_signal {
 #define MCE_DISPLAY_OFF_STRING "off"
 #define MCE_DISPLAY_ON_STRING "on"
 
-#define MCE_DISPLAY_SIG "DisplayPowerStateChange"
-
 static guint mce_display_signals[SIGNAL_COUNT] = { 0 };
 
 typedef GObjectClass MceDisplayClass;
@@ -85,29 +96,83 @@ mce_display_status_update(
     MCE_DISPLAY_STATE state = status;
     MceDisplayPriv* priv = self->priv;
 
+    MCE_TRACE2(display_update, self->state, state);
+    priv->confirmed = g_get_monotonic_time();
+    if (priv->proxy && (self->state != state || !self->valid)) {
+        mce_cache_set(MCE_CACHE_DISPLAY_STATE, state);
+    }
+    /* Confirmed or corrected by MCE */
+    self->provisional = FALSE;
     if (self->state != state) {
         self->state = state;
+        MCE_TRACE2(display_emit, SIGNAL_STATE_CHANGED, state);
         g_signal_emit(self, mce_display_signals[SIGNAL_STATE_CHANGED], 0);
     }
-    if (priv->proxy->valid && !self->valid) {
+    /* Without the proxy, the state comes from the valid shared page */
+    if ((!priv->proxy || priv->proxy->valid) && !self->valid) {
         self->valid = TRUE;
+        MCE_TRACE2(display_emit, SIGNAL_VALID_CHANGED, TRUE);
+        g_signal_emit(self, mce_display_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_display_invalidate(
+    MceDisplay* self)
+{
+    if (self->valid) {
+        self->valid = FALSE;
+        MCE_TRACE2(display_emit, SIGNAL_VALID_CHANGED, FALSE);
         g_signal_emit(self, mce_display_signals[SIGNAL_VALID_CHANGED], 0);
     }
 }
 
+static
+void
+mce_display_waiters_free(
+    GSList* waiters)
+{
+    g_slist_free_full(waiters, g_free);
+}
+
+static
+void
+mce_display_waiters_notify(
+    MceDisplay* self,
+    gboolean fresh)
+{
+    MceDisplayPriv* priv = self->priv;
+    GSList* waiters = g_slist_reverse(priv->waiters);
+    GSList* l;
+
+    /* Callbacks may add new waiters, those will wait for the next reply */
+    priv->waiters = NULL;
+    for (l = waiters; l; l = l->next) {
+        MceDisplayWaiter* waiter = l->data;
+
+        waiter->fn(self, fresh, waiter->arg);
+    }
+    mce_display_waiters_free(waiters);
+}
+
 static
 void
 mce_display_status_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
 {
-    GError* error = NULL;
-    int32_t status = 0;
     MceDisplay* self = MCE_DISPLAY(arg);
+    const gboolean ok = (result && proxy->backend);
+
+    if (self->priv->proxy != proxy) {
+        /* Switched to the shared page, it's the one to believe now */
+        GDEBUG("Ignoring display state reply");
+    } else if (ok) {
+        const int status = proxy->backend->display_state(result);
 
-    if (com_canonical_unity_screen_call_get_display_power_state_finish(
-        COM_CANONICAL_UNITY_SCREEN(proxy), &status, result, &error)) {
         GDEBUG("Display is currently %d", status);
         mce_display_status_update(self, status);
     } else {
@@ -115,23 +180,63 @@ mce_display_status_query_done(
          * We could retry but it's probably not worth the trouble
          * because the next time display state changes we receive
          * display_status_ind signal and sync our state with mce.
-         * Until then, this object stays invalid.
+         * Until then, this object keeps whatever it knew before (if
+         * anything) and the waiters are told that it's not fresh.
          */
         GWARN("Failed to query display state %s", GERRMSG(error));
-        g_error_free(error);
     }
+    self->priv->queries--;
+    mce_display_waiters_notify(self, ok);
     mce_display_unref(self);
 }
 
 static
 void
 mce_display_power_state_change(
-    ComCanonicalUnityScreen* proxy,
-    int32_t status,
+    GDBusConnection* bus,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* name,
+    GVariant* args,
     gpointer arg)
 {
+    MceDisplay* self = MCE_DISPLAY(arg);
+    const MceBackend* backend = self->priv->proxy->backend;
+    int status;
+
+    /*
+     * This is the steady state path. The backend parser only takes
+     * references to the children of the message body. On a private
+     * connection nothing else is allocated per signal (see mce_bus.h
+     * for the details), on the shared one GDBus itself allocates
+     * a dispatch source for each subscriber.
+     */
+    if (!g_variant_is_of_type(args,
+        G_VARIANT_TYPE(backend->display_signature))) {
+        GWARN("Unexpected %s signature %s", name,
+            g_variant_get_type_string(args));
+        return;
+    }
+    status = backend->display_state(args);
+    MCE_TRACE1(display_signal, status);
     GDEBUG("Display is %d", status);
-    mce_display_status_update(MCE_DISPLAY(arg), status);
+    mce_display_status_update(self, status);
+}
+
+static
+void
+mce_display_status_query_submit(
+    MceDisplay* self)
+{
+    MceDisplayPriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+    const MceBackend* backend = proxy->backend;
+
+    priv->queries++;
+    mce_proxy_call(proxy, backend->request(proxy), backend->display_query,
+        NULL, G_VARIANT_TYPE(backend->display_reply),
+        mce_display_status_query_done, mce_display_ref(self));
 }
 
 static
@@ -143,21 +248,33 @@ mce_display_status_query(
     MceProxy* proxy = priv->proxy;
 
     /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceDisplay is created. In that case we have to wait
-     * for the valid signal before we can connect the display state
+     * The connection and the backend may not be known at the time
+     * when MceDisplay is created. In that case we have to wait for
+     * the valid signal before we can subscribe to the display state
      * signal and submit the initial query.
      */
-    if (proxy->signal && !priv->display_status_ind_id) {
-        priv->display_status_ind_id = g_signal_connect(proxy->signal,
-            MCE_DISPLAY_SIG, G_CALLBACK(mce_display_power_state_change), self);
+    if (!priv->display_status_ind_id && proxy->backend) {
+        priv->display_status_ind_id = mce_proxy_subscribe(proxy,
+            proxy->backend->display_signal, mce_display_power_state_change,
+            self);
     }
-    if (proxy->request && proxy->valid) {
-        com_canonical_unity_screen_call_get_display_power_state(proxy->request, NULL,
-            mce_display_status_query_done, mce_display_ref(self));
+    if (proxy->valid) {
+        mce_display_status_query_submit(self);
     }
 }
 
+static
+void
+mce_display_shm_changed(
+    MceShm* shm,
+    void* arg);
+
+static
+void
+mce_display_shm_lost(
+    MceShm* shm,
+    void* arg);
+
 static
 void
 mce_display_valid_changed(
@@ -167,12 +284,99 @@ mce_display_valid_changed(
     MceDisplay* self = MCE_DISPLAY(arg);
 
     if (proxy->valid) {
+        MceDisplayPriv* priv = self->priv;
+
+        /*
+         * The publisher may have come back together with MCE. If it
+         * has, we drop the proxy when the page arrives.
+         */
+        if (!priv->shm) {
+            priv->shm = mce_shm_attach(mce_display_shm_changed,
+                mce_display_shm_lost, self);
+        }
         mce_display_status_query(self);
     } else {
-        if (self->valid) {
-            self->valid = FALSE;
-            g_signal_emit(self, mce_display_signals[SIGNAL_VALID_CHANGED], 0);
+        MceDisplayPriv* priv = self->priv;
+
+        /* The subscription doesn't survive reconnect */
+        mce_proxy_unsubscribe(proxy, priv->display_status_ind_id);
+        priv->display_status_ind_id = 0;
+        mce_display_invalidate(self);
+    }
+}
+
+static
+void
+mce_display_proxy_attach(
+    MceDisplay* self)
+{
+    MceDisplayPriv* priv = self->priv;
+
+    GASSERT(!priv->proxy);
+    priv->proxy = mce_proxy_new();
+    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
+        mce_display_valid_changed, self);
+    mce_display_status_query(self);
+}
+
+static
+void
+mce_display_proxy_detach(
+    MceDisplay* self)
+{
+    MceDisplayPriv* priv = self->priv;
+
+    if (priv->proxy) {
+        mce_proxy_unsubscribe(priv->proxy, priv->display_status_ind_id);
+        mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+        mce_proxy_unref(priv->proxy);
+        priv->display_status_ind_id = 0;
+        priv->proxy_valid_id = 0;
+        priv->proxy = NULL;
+    }
+}
+
+static
+void
+mce_display_shm_lost(
+    MceShm* shm,
+    void* arg)
+{
+    MceDisplay* self = MCE_DISPLAY(arg);
+    MceDisplayPriv* priv = self->priv;
+
+    mce_shm_detach(priv->shm);
+    priv->shm = NULL;
+    if (!priv->proxy) {
+        /* Fall back to talking to MCE directly */
+        mce_display_invalidate(self);
+        mce_display_proxy_attach(self);
+    }
+}
+
+static
+void
+mce_display_shm_changed(
+    MceShm* shm,
+    void* arg)
+{
+    MceDisplay* self = MCE_DISPLAY(arg);
+    MceShmState state;
+
+    if (mce_shm_read(shm, &state)) {
+        /* Attached after falling back to D-Bus */
+        mce_display_proxy_detach(self);
+        if (state.display_valid) {
+            mce_display_status_update(self, state.display_state);
+        } else {
+            mce_display_invalidate(self);
         }
+        /* Waiters may drop the last reference */
+        mce_display_ref(self);
+        mce_display_waiters_notify(self, state.display_valid);
+        mce_display_unref(self);
+    } else {
+        mce_display_shm_lost(shm, self);
     }
 }
 
@@ -187,10 +391,27 @@ mce_display_new()
     static MceDisplay* mce_display_instance = NULL;
 
     if (mce_display_instance) {
-        mce_display_ref(mce_display_instance);
+        if (!mce_linger_revive(mce_display_instance)) {
+            mce_display_ref(mce_display_instance);
+        }
     } else {
+        MceDisplayPriv* priv;
+
         mce_display_instance = g_object_new(MCE_DISPLAY_TYPE, NULL);
-        mce_display_status_query(mce_display_instance);
+        priv = mce_display_instance->priv;
+        priv->shm = mce_shm_attach(mce_display_shm_changed,
+            mce_display_shm_lost, mce_display_instance);
+        if (!priv->shm) {
+            int state;
+
+            /* Serve the last known state until MCE confirms it */
+            if (mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+                MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &state)) {
+                mce_display_instance->state = state;
+                mce_display_instance->provisional = TRUE;
+            }
+            mce_display_proxy_attach(mce_display_instance);
+        }
         g_object_add_weak_pointer(G_OBJECT(mce_display_instance),
             (gpointer*)(&mce_display_instance));
     }
@@ -211,18 +432,55 @@ void
 mce_display_unref(
     MceDisplay* self)
 {
-    if (G_LIKELY(self)) {
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
         g_object_unref(MCE_DISPLAY(self));
     }
 }
 
+gboolean
+mce_display_get_state_fresh(
+    MceDisplay* self,
+    guint max_age_ms,
+    MceDisplayFreshFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceDisplayPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        /* The shared page is kept up to date by the publisher */
+        if (self->valid && ((priv->shm && !priv->proxy) ||
+            (g_get_monotonic_time() -
+            priv->confirmed) <= (gint64)max_age_ms * 1000)) {
+            fn(self, TRUE, arg);
+            return TRUE;
+        } else {
+            MceDisplayWaiter* waiter = g_new(MceDisplayWaiter, 1);
+
+            waiter->fn = fn;
+            waiter->arg = arg;
+            priv->waiters = g_slist_prepend(priv->waiters, waiter);
+
+            /*
+             * Join the query which is already in progress. If there's
+             * no connection to MCE, the query will be submitted when
+             * it appears. In shared mode, wait for the page update.
+             */
+            if (!priv->queries && proxy && proxy->valid) {
+                mce_display_status_query_submit(self);
+            }
+        }
+    }
+    return FALSE;
+}
+
 gulong
 mce_display_add_valid_changed_handler(
     MceDisplay* self,
     MceDisplayFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
         SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
 }
 
@@ -232,7 +490,57 @@ mce_display_add_state_changed_handler(
     MceDisplayFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_display_add_valid_changed_handler_full(
+    MceDisplay* self,
+    MCE_PRIORITY priority,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_display_add_valid_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_display_add_state_changed_handler_full(
+    MceDisplay* self,
+    MCE_PRIORITY priority,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_display_add_state_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_display_add_valid_changed_handler_in_context(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_dispatch_connect(self,
+        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_display_add_state_changed_handler_in_context(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_dispatch_connect(self,
         SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
 }
 
@@ -268,9 +576,6 @@ mce_display_init(
         MceDisplayPriv);
 
     self->priv = priv;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_display_valid_changed, self);
 }
 
 static
@@ -281,12 +586,10 @@ mce_display_finalize(
     MceDisplay* self = MCE_DISPLAY(object);
     MceDisplayPriv* priv = self->priv;
 
-    if (priv->display_status_ind_id) {
-        g_signal_handler_disconnect(priv->proxy->signal,
-            priv->display_status_ind_id);
-    }
-    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
-    mce_proxy_unref(priv->proxy);
+    mce_display_waiters_free(priv->waiters);
+    mce_shm_detach(priv->shm);
+    mce_display_proxy_detach(self);
+    mce_cache_flush();
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
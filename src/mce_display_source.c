@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_display.h"
+#include "mce_log_p.h"
+
+/*
+ * GSource which only dispatches while the display is in the given
+ * state. While it's gated off, it has no ready time and therefore
+ * never wakes up the main loop. Display state change handlers update
+ * the ready time, which wakes up the owning context when necessary.
+ */
+
+enum mce_display_source_events {
+    DISPLAY_EVENT_VALID,
+    DISPLAY_EVENT_STATE,
+    DISPLAY_EVENT_COUNT
+};
+
+typedef struct mce_display_gated_source {
+    GSource source;
+    MceDisplay* display;
+    MCE_DISPLAY_STATE state;
+    gint64 interval;
+    gint64 due;
+    gulong display_event_id[DISPLAY_EVENT_COUNT];
+} MceDisplayGatedSource;
+
+static
+gboolean
+mce_display_gated_source_open(
+    MceDisplayGatedSource* self)
+{
+    MceDisplay* display = self->display;
+
+    return display->valid && display->state == self->state;
+}
+
+static
+void
+mce_display_gated_source_update(
+    MceDisplay* display,
+    void* arg)
+{
+    MceDisplayGatedSource* self = arg;
+
+    /* If the work is overdue, it gets dispatched right away */
+    g_source_set_ready_time(&self->source,
+        mce_display_gated_source_open(self) ? self->due : -1);
+}
+
+static
+gboolean
+mce_display_gated_source_prepare(
+    GSource* source,
+    gint* timeout)
+{
+    MceDisplayGatedSource* self = (MceDisplayGatedSource*)source;
+
+    /* The timeout is derived from the ready time */
+    *timeout = -1;
+    return mce_display_gated_source_open(self) &&
+        g_source_get_time(source) >= self->due;
+}
+
+static
+gboolean
+mce_display_gated_source_check(
+    GSource* source)
+{
+    MceDisplayGatedSource* self = (MceDisplayGatedSource*)source;
+
+    return mce_display_gated_source_open(self) &&
+        g_source_get_time(source) >= self->due;
+}
+
+static
+gboolean
+mce_display_gated_source_dispatch(
+    GSource* source,
+    GSourceFunc callback,
+    gpointer data)
+{
+    MceDisplayGatedSource* self = (MceDisplayGatedSource*)source;
+
+    self->due = g_source_get_time(source) + self->interval;
+    g_source_set_ready_time(source, self->due);
+    if (!callback) {
+        GWARN("Display gated source dispatched without callback");
+        return G_SOURCE_REMOVE;
+    }
+    return callback(data);
+}
+
+static
+void
+mce_display_gated_source_finalize(
+    GSource* source)
+{
+    MceDisplayGatedSource* self = (MceDisplayGatedSource*)source;
+
+    mce_display_remove_all_handlers(self->display, self->display_event_id);
+    mce_display_unref(self->display);
+}
+
+static GSourceFuncs mce_display_gated_source_funcs = {
+    mce_display_gated_source_prepare,
+    mce_display_gated_source_check,
+    mce_display_gated_source_dispatch,
+    mce_display_gated_source_finalize
+};
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+GSource*
+mce_display_gated_source_new(
+    MceDisplay* display,
+    MCE_DISPLAY_STATE state,
+    guint interval_ms)
+{
+    if (G_LIKELY(display)) {
+        GSource* source = g_source_new(&mce_display_gated_source_funcs,
+            sizeof(MceDisplayGatedSource));
+        MceDisplayGatedSource* self = (MceDisplayGatedSource*)source;
+
+        self->display = mce_display_ref(display);
+        self->state = state;
+        self->interval = (gint64)interval_ms * 1000;
+        self->due = g_get_monotonic_time() + self->interval;
+        self->display_event_id[DISPLAY_EVENT_VALID] =
+            mce_display_add_valid_changed_handler(display,
+                mce_display_gated_source_update, self);
+        self->display_event_id[DISPLAY_EVENT_STATE] =
+            mce_display_add_state_changed_handler(display,
+                mce_display_gated_source_update, self);
+        g_source_set_name(source, "MceDisplayGatedSource");
+        mce_display_gated_source_update(display, self);
+        return source;
+    }
+    return NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
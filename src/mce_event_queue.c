@@ -0,0 +1,629 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_event_queue.h"
+#include "mce_battery.h"
+#include "mce_call_state.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_tklock.h"
+#include "mce_log_p.h"
+
+#include <sys/eventfd.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define MCE_EVENT_QUEUE_DEFAULT_CAPACITY (64)
+#define MCE_EVENT_MAX_SIGNALS (3)
+
+typedef struct mce_event_source {
+    const char* type_name;
+    const char* signal;
+    MCE_EVENT_TYPE type;
+    int (*value)(gpointer object);
+    int (*valid)(gpointer object);
+} MceEventSource;
+
+typedef struct mce_event_link {
+    MceEventQueue* queue;
+    const MceEventSource* source;
+    gulong id;
+} MceEventLink;
+
+typedef struct mce_event_sub {
+    GObject* object;
+    guint count;
+    MceEventLink link[MCE_EVENT_MAX_SIGNALS];
+} MceEventSub;
+
+struct mce_event_queue {
+    GMutex mutex; /* Protects the ring, the consumer may be elsewhere */
+    MCE_EVENT_QUEUE_OVERFLOW overflow;
+    MceEvent* events;
+    guint capacity;
+    guint head;
+    guint count;
+    guint dropped;
+    guint kinds;
+    int fd;
+    GSList* subs;
+};
+
+/*==========================================================================*
+ * Sources
+ *==========================================================================*/
+
+static
+int
+mce_event_display_valid(
+    gpointer object)
+{
+    return ((MceDisplay*)object)->valid;
+}
+
+static
+int
+mce_event_display_state(
+    gpointer object)
+{
+    return ((MceDisplay*)object)->state;
+}
+
+static
+int
+mce_event_battery_valid(
+    gpointer object)
+{
+    return ((MceBattery*)object)->valid;
+}
+
+static
+int
+mce_event_battery_level(
+    gpointer object)
+{
+    return ((MceBattery*)object)->level;
+}
+
+static
+int
+mce_event_battery_status(
+    gpointer object)
+{
+    return ((MceBattery*)object)->status;
+}
+
+static
+int
+mce_event_charger_valid(
+    gpointer object)
+{
+    return ((MceCharger*)object)->valid;
+}
+
+static
+int
+mce_event_charger_state(
+    gpointer object)
+{
+    return ((MceCharger*)object)->state;
+}
+
+static
+int
+mce_event_call_valid(
+    gpointer object)
+{
+    return ((MceCallState*)object)->valid;
+}
+
+static
+int
+mce_event_call_state(
+    gpointer object)
+{
+    return ((MceCallState*)object)->state;
+}
+
+static
+int
+mce_event_call_type(
+    gpointer object)
+{
+    return ((MceCallState*)object)->type;
+}
+
+static
+int
+mce_event_inactivity_valid(
+    gpointer object)
+{
+    return ((MceInactivity*)object)->valid;
+}
+
+static
+int
+mce_event_inactivity_status(
+    gpointer object)
+{
+    return ((MceInactivity*)object)->status;
+}
+
+static
+int
+mce_event_tklock_valid(
+    gpointer object)
+{
+    return ((MceTklock*)object)->valid;
+}
+
+static
+int
+mce_event_tklock_mode(
+    gpointer object)
+{
+    return ((MceTklock*)object)->mode;
+}
+
+static
+int
+mce_event_tklock_locked(
+    gpointer object)
+{
+    return ((MceTklock*)object)->locked;
+}
+
+/* Rows of the same type must be adjacent */
+static const MceEventSource mce_event_sources[] = {
+    { "MceDisplay", "mce-display-valid-changed",
+      MCE_EVENT_VALID, mce_event_display_valid,
+      mce_event_display_valid },
+    { "MceDisplay", "mce-display-state-changed",
+      MCE_EVENT_DISPLAY_STATE, mce_event_display_state,
+      mce_event_display_valid },
+    { "MceBattery", "mce-battery-valid-changed",
+      MCE_EVENT_VALID, mce_event_battery_valid,
+      mce_event_battery_valid },
+    { "MceBattery", "mce-battery-level-changed",
+      MCE_EVENT_BATTERY_LEVEL, mce_event_battery_level,
+      mce_event_battery_valid },
+    { "MceBattery", "mce-battery-status-changed",
+      MCE_EVENT_BATTERY_STATUS, mce_event_battery_status,
+      mce_event_battery_valid },
+    { "MceCharger", "mce-charger-valid-changed",
+      MCE_EVENT_VALID, mce_event_charger_valid,
+      mce_event_charger_valid },
+    { "MceCharger", "mce-charger-state-changed",
+      MCE_EVENT_CHARGER_STATE, mce_event_charger_state,
+      mce_event_charger_valid },
+    { "MceCallState", "mce-call-state-valid-changed",
+      MCE_EVENT_VALID, mce_event_call_valid,
+      mce_event_call_valid },
+    { "MceCallState", "mce-call-state-state-changed",
+      MCE_EVENT_CALL_STATE, mce_event_call_state,
+      mce_event_call_valid },
+    { "MceCallState", "mce-call-state-type-changed",
+      MCE_EVENT_CALL_TYPE, mce_event_call_type,
+      mce_event_call_valid },
+    { "MceInactivity", "mce-inactivity-valid-changed",
+      MCE_EVENT_VALID, mce_event_inactivity_valid,
+      mce_event_inactivity_valid },
+    { "MceInactivity", "mce-inactivity-status-changed",
+      MCE_EVENT_INACTIVITY, mce_event_inactivity_status,
+      mce_event_inactivity_valid },
+    { "MceTklock", "mce-tklock-valid-changed",
+      MCE_EVENT_VALID, mce_event_tklock_valid,
+      mce_event_tklock_valid },
+    { "MceTklock", "mce-tklock-mode-changed",
+      MCE_EVENT_TKLOCK_MODE, mce_event_tklock_mode,
+      mce_event_tklock_valid },
+    { "MceTklock", "mce-tklock-locked-changed",
+      MCE_EVENT_TKLOCK_LOCKED, mce_event_tklock_locked,
+      mce_event_tklock_valid }
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MceEvent*
+mce_event_queue_at(
+    MceEventQueue* self,
+    guint i)
+{
+    return self->events + (self->head + i) % self->capacity;
+}
+
+static
+void
+mce_event_queue_delete(
+    MceEventQueue* self,
+    guint i)
+{
+    /* Shift the newer events, it only happens on overflow or removal */
+    for (; i + 1 < self->count; i++) {
+        *mce_event_queue_at(self, i) = *mce_event_queue_at(self, i + 1);
+    }
+    self->count--;
+}
+
+static
+gboolean
+mce_event_same_kind(
+    const MceEvent* event,
+    gpointer object,
+    MCE_EVENT_TYPE type)
+{
+    return event->object == object && event->type == type;
+}
+
+static
+guint
+mce_event_queue_superseded(
+    MceEventQueue* self,
+    gpointer object,
+    MCE_EVENT_TYPE type)
+{
+    guint i, j;
+
+    /* The oldest event of the same kind as the incoming one */
+    for (i = 0; i < self->count; i++) {
+        if (mce_event_same_kind(mce_event_queue_at(self, i), object, type)) {
+            return i;
+        }
+    }
+
+    /*
+     * Otherwise the oldest event followed by a newer one of the same
+     * kind. There is one if the incoming kind isn't in the queue and
+     * there are no fewer slots than kinds.
+     */
+    for (i = 0; i < self->count; i++) {
+        const MceEvent* old = mce_event_queue_at(self, i);
+
+        for (j = i + 1; j < self->count; j++) {
+            if (mce_event_same_kind(mce_event_queue_at(self, j),
+                old->object, old->type)) {
+                return i;
+            }
+        }
+    }
+    return 0;
+}
+
+static
+void
+mce_event_queue_grow(
+    MceEventQueue* self,
+    guint capacity)
+{
+    MceEvent* events = g_new(MceEvent, capacity);
+    guint i;
+
+    for (i = 0; i < self->count; i++) {
+        events[i] = *mce_event_queue_at(self, i);
+    }
+    g_free(self->events);
+    self->events = events;
+    self->capacity = capacity;
+    self->head = 0;
+}
+
+static
+void
+mce_event_queue_drain_fd(
+    MceEventQueue* self)
+{
+    guint64 counter;
+
+    if (read(self->fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+        GWARN("Failed to read eventfd: %s", strerror(errno));
+    }
+}
+
+static
+void
+mce_event_queue_push(
+    MceEventQueue* self,
+    GObject* object,
+    MCE_EVENT_TYPE type,
+    int value,
+    MCE_EVENT_REASON reason)
+{
+    MceEvent* event;
+
+    g_mutex_lock(&self->mutex);
+    if (self->count == self->capacity) {
+        mce_event_queue_delete(self,
+            (self->overflow == MCE_EVENT_QUEUE_KEEP_LATEST) ?
+            mce_event_queue_superseded(self, object, type) : 0);
+        self->dropped++;
+    }
+
+    event = mce_event_queue_at(self, self->count++);
+    event->object = object;
+    event->type = type;
+    event->value = value;
+    event->reason = reason;
+    event->time = g_get_monotonic_time();
+    if (self->count == 1) {
+        const guint64 one = 1;
+
+        if (write(self->fd, &one, sizeof(one)) < 0) {
+            GWARN("Failed to write eventfd: %s", strerror(errno));
+        }
+    }
+    g_mutex_unlock(&self->mutex);
+}
+
+static
+void
+mce_event_queue_signal(
+    GObject* object,
+    gpointer data)
+{
+    MceEventLink* link = data;
+    const MceEventSource* source = link->source;
+    MCE_EVENT_REASON reason;
+
+    /*
+     * The state arrives before the object becomes valid when MCE
+     * (re)appears, and the valid flag drops when MCE goes away.
+     */
+    if (source->type == MCE_EVENT_VALID) {
+        reason = source->valid(object) ? MCE_EVENT_REASON_SYNC :
+            MCE_EVENT_REASON_LOST;
+    } else {
+        reason = source->valid(object) ? MCE_EVENT_REASON_CHANGE :
+            MCE_EVENT_REASON_SYNC;
+    }
+    mce_event_queue_push(link->queue, object, source->type,
+        source->value(object), reason);
+}
+
+static
+MceEventSub*
+mce_event_queue_find(
+    MceEventQueue* self,
+    gpointer object)
+{
+    GSList* l;
+
+    for (l = self->subs; l; l = l->next) {
+        MceEventSub* sub = l->data;
+
+        if (sub->object == object) {
+            return sub;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+mce_event_queue_sub_free(
+    MceEventSub* sub)
+{
+    guint i;
+
+    for (i = 0; i < sub->count; i++) {
+        g_signal_handler_disconnect(sub->object, sub->link[i].id);
+    }
+    g_object_unref(sub->object);
+    g_slice_free(MceEventSub, sub);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceEventQueue*
+mce_event_queue_new(
+    guint capacity,
+    MCE_EVENT_QUEUE_OVERFLOW overflow)
+{
+    const int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (fd >= 0) {
+        MceEventQueue* self = g_slice_new0(MceEventQueue);
+
+        g_mutex_init(&self->mutex);
+        self->fd = fd;
+        self->overflow = overflow;
+        self->capacity = capacity ? capacity :
+            MCE_EVENT_QUEUE_DEFAULT_CAPACITY;
+        self->events = g_new(MceEvent, self->capacity);
+        return self;
+    } else {
+        GWARN("Failed to create eventfd: %s", strerror(errno));
+        return NULL;
+    }
+}
+
+void
+mce_event_queue_free(
+    MceEventQueue* self)
+{
+    if (G_LIKELY(self)) {
+        g_slist_free_full(self->subs, (GDestroyNotify)
+            mce_event_queue_sub_free);
+        close(self->fd);
+        g_free(self->events);
+        g_mutex_clear(&self->mutex);
+        g_slice_free(MceEventQueue, self);
+    }
+}
+
+gboolean
+mce_event_queue_add(
+    MceEventQueue* self,
+    gpointer object)
+{
+    if (G_LIKELY(self) && G_IS_OBJECT(object)) {
+        const char* type_name = G_OBJECT_TYPE_NAME(object);
+        MceEventSub* sub;
+        guint i;
+
+        if (mce_event_queue_find(self, object)) {
+            return TRUE;
+        }
+
+        sub = g_slice_new0(MceEventSub);
+        for (i = 0; i < G_N_ELEMENTS(mce_event_sources); i++) {
+            const MceEventSource* source = mce_event_sources + i;
+
+            if (!strcmp(source->type_name, type_name)) {
+                MceEventLink* link = sub->link + sub->count++;
+
+                GASSERT(sub->count <= MCE_EVENT_MAX_SIGNALS);
+                link->queue = self;
+                link->source = source;
+                link->id = g_signal_connect(object, source->signal,
+                    G_CALLBACK(mce_event_queue_signal), link);
+            }
+        }
+
+        if (sub->count) {
+            sub->object = g_object_ref(object);
+            self->subs = g_slist_append(self->subs, sub);
+            self->kinds += sub->count;
+            if (self->overflow == MCE_EVENT_QUEUE_KEEP_LATEST &&
+                self->capacity < self->kinds) {
+                /* See mce_event_queue_superseded() */
+                g_mutex_lock(&self->mutex);
+                mce_event_queue_grow(self, self->kinds);
+                g_mutex_unlock(&self->mutex);
+            }
+            return TRUE;
+        }
+        GWARN("Unsupported object type %s", type_name);
+        g_slice_free(MceEventSub, sub);
+    }
+    return FALSE;
+}
+
+void
+mce_event_queue_remove(
+    MceEventQueue* self,
+    gpointer object)
+{
+    MceEventSub* sub = G_LIKELY(self) ? mce_event_queue_find(self, object) :
+        NULL;
+
+    if (sub) {
+        guint i = 0;
+
+        /* Queued events don't keep the object alive */
+        g_mutex_lock(&self->mutex);
+        while (i < self->count) {
+            if (mce_event_queue_at(self, i)->object == object) {
+                mce_event_queue_delete(self, i);
+            } else {
+                i++;
+            }
+        }
+        if (!self->count) {
+            mce_event_queue_drain_fd(self);
+        }
+        g_mutex_unlock(&self->mutex);
+        self->subs = g_slist_remove(self->subs, sub);
+        self->kinds -= sub->count;
+        mce_event_queue_sub_free(sub);
+    }
+}
+
+int
+mce_event_queue_fd(
+    MceEventQueue* self)
+{
+    return G_LIKELY(self) ? self->fd : -1;
+}
+
+guint
+mce_event_queue_pop_batch(
+    MceEventQueue* self,
+    MceEvent* events,
+    guint max)
+{
+    guint n = 0;
+
+    if (G_LIKELY(self) && G_LIKELY(events)) {
+        g_mutex_lock(&self->mutex);
+        n = MIN(self->count, max);
+
+        /* Copy in at most two chunks */
+        if (n) {
+            const guint first = MIN(n, self->capacity - self->head);
+
+            memcpy(events, self->events + self->head,
+                sizeof(MceEvent) * first);
+            memcpy(events + first, self->events,
+                sizeof(MceEvent) * (n - first));
+            self->head = (self->head + n) % self->capacity;
+            self->count -= n;
+            if (!self->count) {
+                mce_event_queue_drain_fd(self);
+            }
+        }
+        g_mutex_unlock(&self->mutex);
+    }
+    return n;
+}
+
+guint
+mce_event_queue_dropped(
+    MceEventQueue* self)
+{
+    guint dropped = 0;
+
+    if (G_LIKELY(self)) {
+        g_mutex_lock(&self->mutex);
+        dropped = self->dropped;
+        g_mutex_unlock(&self->mutex);
+    }
+    return dropped;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_handler_p.h"
+#include "mce_log_p.h"
+
+/* Minimum interval between warnings about the same handler */
+#define MCE_HANDLER_WARN_INTERVAL (10000000) /* microseconds */
+
+typedef void
+(*MceHandlerFunc)(
+    GObject* object,
+    void* arg);
+
+struct mce_handler {
+    const char* signal;
+    MceHandlerFunc fn;
+    void* arg;
+    guint calls;
+    guint64 total;
+    guint max;
+    guint slow;
+    guint suppressed;
+    gint64 last_warning;
+};
+
+/*
+ * All timed handlers in the order of registration. Deferred and
+ * in-context handlers get registered and invoked on other threads too.
+ */
+G_LOCK_DEFINE_STATIC(mce_handlers);
+static GSList* mce_handlers = NULL;
+static guint mce_handler_budget_us = MCE_HANDLER_BUDGET_DEFAULT;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_handler_warn(
+    MceHandler* handler,
+    guint elapsed,
+    gint64 now)
+{
+    if (!handler->last_warning ||
+        (now - handler->last_warning) >= MCE_HANDLER_WARN_INTERVAL) {
+        if (handler->suppressed) {
+            GWARN("Handler %p(%p) of %s took %u ms (and %u more times "
+                "over %u ms)", handler->fn, handler->arg, handler->signal,
+                elapsed / 1000, handler->suppressed,
+                mce_handler_budget_us / 1000);
+        } else {
+            GWARN("Handler %p(%p) of %s took %u ms (budget %u ms)",
+                handler->fn, handler->arg, handler->signal,
+                elapsed / 1000, mce_handler_budget_us / 1000);
+        }
+        handler->suppressed = 0;
+        handler->last_warning = now;
+    } else {
+        handler->suppressed++;
+    }
+}
+
+static
+void
+mce_handler_signal(
+    GObject* object,
+    gpointer data)
+{
+    /* The closure (and therefore the handler) survives disconnect */
+    mce_handler_invoke(data, object);
+}
+
+static
+void
+mce_handler_destroy(
+    gpointer data,
+    GClosure* closure)
+{
+    mce_handler_free(data);
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+MceHandler*
+mce_handler_new(
+    const char* signal,
+    GCallback fn,
+    void* arg)
+{
+    MceHandler* handler = g_slice_new0(MceHandler);
+
+    handler->signal = signal;
+    handler->fn = (MceHandlerFunc)fn;
+    handler->arg = arg;
+    G_LOCK(mce_handlers);
+    mce_handlers = g_slist_append(mce_handlers, handler);
+    G_UNLOCK(mce_handlers);
+    return handler;
+}
+
+void
+mce_handler_invoke(
+    MceHandler* handler,
+    GObject* object)
+{
+    const gint64 start = g_get_monotonic_time();
+    gint64 now;
+    guint elapsed;
+
+    handler->fn(object, handler->arg);
+    now = g_get_monotonic_time();
+    elapsed = (guint)(now - start);
+    G_LOCK(mce_handlers);
+    handler->calls++;
+    handler->total += elapsed;
+    if (handler->max < elapsed) {
+        handler->max = elapsed;
+    }
+    if (mce_handler_budget_us && elapsed > mce_handler_budget_us) {
+        handler->slow++;
+        mce_handler_warn(handler, elapsed, now);
+    }
+    G_UNLOCK(mce_handlers);
+}
+
+void
+mce_handler_free(
+    MceHandler* handler)
+{
+    G_LOCK(mce_handlers);
+    mce_handlers = g_slist_remove(mce_handlers, handler);
+    G_UNLOCK(mce_handlers);
+    g_slice_free(MceHandler, handler);
+}
+
+gulong
+mce_handler_connect(
+    gpointer object,
+    const char* signal,
+    GCallback fn,
+    void* arg)
+{
+    return g_signal_connect_data(object, signal,
+        G_CALLBACK(mce_handler_signal), mce_handler_new(signal, fn, arg),
+        mce_handler_destroy, 0);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+mce_handler_set_budget(
+    guint budget_us)
+{
+    mce_handler_budget_us = budget_us;
+}
+
+guint
+mce_handler_budget(
+    void)
+{
+    return mce_handler_budget_us;
+}
+
+guint
+mce_handler_get_stats(
+    MceHandlerStats* stats,
+    guint count)
+{
+    guint n = 0;
+    GSList* l;
+
+    G_LOCK(mce_handlers);
+    for (l = mce_handlers; l; l = l->next, n++) {
+        if (stats && n < count) {
+            const MceHandler* handler = l->data;
+            MceHandlerStats* out = stats + n;
+
+            out->signal = handler->signal;
+            out->fn = (GCallback)handler->fn;
+            out->arg = handler->arg;
+            out->calls = handler->calls;
+            out->total = handler->total;
+            out->max = handler->max;
+            out->slow = handler->slow;
+        }
+    }
+    G_UNLOCK(mce_handlers);
+    return n;
+}
+
+void
+mce_handler_reset_stats(
+    void)
+{
+    GSList* l;
+
+    G_LOCK(mce_handlers);
+    for (l = mce_handlers; l; l = l->next) {
+        MceHandler* handler = l->data;
+
+        handler->calls = 0;
+        handler->total = 0;
+        handler->max = 0;
+        handler->slow = 0;
+        handler->suppressed = 0;
+        handler->last_warning = 0;
+    }
+    G_UNLOCK(mce_handlers);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_HANDLER_PRIVATE_H
+#define MCE_HANDLER_PRIVATE_H
+
+#include "mce_handler.h"
+
+typedef struct mce_handler MceHandler;
+
+/*
+ * A timed handler which is invoked by whoever has created it. The
+ * handler must have (GObject*, void*) signature, and the signal name
+ * (which only shows up in the stats) must be a static string.
+ */
+MceHandler*
+mce_handler_new(
+    const char* signal,
+    GCallback fn,
+    void* arg);
+
+void
+mce_handler_invoke(
+    MceHandler* handler,
+    GObject* object);
+
+void
+mce_handler_free(
+    MceHandler* handler);
+
+/*
+ * Connects a handler which gets timed on every invocation. The handler
+ * must have (GObject*, void*) signature, and the signal name must be
+ * a static string.
+ *
+ * The returned id is a regular signal handler id and is released
+ * with g_signal_handler_disconnect()
+ */
+gulong
+mce_handler_connect(
+    gpointer object,
+    const char* signal,
+    GCallback fn,
+    void* arg);
+
+#endif /* MCE_HANDLER_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
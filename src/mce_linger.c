@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+static guint mce_linger_ms = 0;
+static GQuark mce_linger_quark = 0;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+GQuark
+mce_linger_timer_quark(
+    void)
+{
+    if (!mce_linger_quark) {
+        mce_linger_quark = g_quark_from_static_string("mce-linger-timer");
+    }
+    return mce_linger_quark;
+}
+
+static
+gboolean
+mce_linger_expired(
+    gpointer object)
+{
+    GDEBUG("%s is no longer needed", G_OBJECT_TYPE_NAME(object));
+    g_object_steal_qdata(G_OBJECT(object), mce_linger_timer_quark());
+    g_object_unref(object);
+    return G_SOURCE_REMOVE;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gboolean
+mce_linger_unref(
+    gpointer object)
+{
+    GObject* obj = G_OBJECT(object);
+    const GQuark quark = mce_linger_timer_quark();
+
+    if (mce_linger_ms && obj->ref_count == 1 &&
+        !g_object_get_qdata(obj, quark)) {
+        g_object_set_qdata(obj, quark, GUINT_TO_POINTER
+            (g_timeout_add(mce_linger_ms, mce_linger_expired, obj)));
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean
+mce_linger_revive(
+    gpointer object)
+{
+    const guint id = GPOINTER_TO_UINT(g_object_steal_qdata(G_OBJECT(object),
+        mce_linger_timer_quark()));
+
+    if (id) {
+        g_source_remove(id);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+mce_linger_set_time(
+    guint ms)
+{
+    mce_linger_ms = ms;
+}
+
+guint
+mce_linger_time(
+    void)
+{
+    return mce_linger_ms;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
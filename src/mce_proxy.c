@@ -35,100 +35,1324 @@
  */
 
 #include "mce_proxy.h"
+#include "mce_bus.h"
+#include "mce_call.h"
+#include "mce_display.h"
+#include "mce_tklock.h"
+#include "mce_record.h"
+#include "mce_record_p.h"
+#include "mce_trace_p.h"
+#include "mce_linger_p.h"
 #include "mce_log_p.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
 /* Generated headers */
 #include "com.canonical.Unity.Screen.h"
+#include "com.nokia.mce.request.h"
+#include "com.nokia.mce.signal.h"
+
+GLOG_MODULE_DEFINE("mce");
+
+typedef struct mce_signal_source {
+    GSource source;
+    const MceBackend* backend;
+    GMutex mutex;
+    GQueue messages;
+    MceProxy* proxy;
+} MceSignalSource;
+
+typedef struct mce_signal_sub {
+    gint ref_count;
+    guint id;
+    char* member;
+    GDBusSignalCallback fn;
+    void* arg;
+} MceSignalSub;
+
+struct mce_proxy_priv {
+    GDBusConnection* bus;
+    MceSignalSource* signal_source;
+    guint filter_id;
+    GSList* subs;
+    guint last_sub_id;
+    gboolean bus_own;
+    gboolean shared_lost;
+    GCancellable* cancel;
+    gulong bus_closed_id;
+    guint reconnect_id;
+    guint reconnect_delay;
+    gint64 lost_time;
+    char* owner;
+    guint mce_watch_id;
+    guint nokia_watch_id;
+    guint record_signal_id;
+    guint record_nokia_signal_id;
+};
+
+typedef struct mce_recorder {
+    FILE* out;
+    gint64 start;
+} MceRecorder;
+
+typedef struct mce_proxy_call {
+    MceProxy* proxy;
+    GDBusProxy* target;
+    char* method;
+    GVariant* params;
+    GVariantType* reply_type;
+    MceProxyCallFunc fn;
+    void* arg;
+    GCancellable* cancel;
+    gint64 start;
+    gint64 hedge_start;
+    guint hedge_id;
+    guint pending;
+    gboolean done;
+} MceProxyCall;
+
+/* Latency samples (microseconds) the hedge delay is derived from */
+#define MCE_CALL_LATENCY_SAMPLES (64)
+#define MCE_CALL_HEDGE_MIN_SAMPLES (8)
+#define MCE_CALL_HEDGE_DEFAULT_DELAY (100000)
+#define MCE_CALL_HEDGE_MIN_DELAY (1000)
+
+typedef struct mce_call_latency {
+    guint sample[MCE_CALL_LATENCY_SAMPLES];
+    guint count;
+    guint next;
+} MceCallLatency;
+
+enum mce_proxy_signal {
+    SIGNAL_VALID_CHANGED,
+    SIGNAL_NOKIA_VALID_CHANGED,
+    SIGNAL_COUNT
+};
+
+/* Subscribers to the same signal dispatched without allocation */
+#define MCE_SIGNAL_SUBS_PREALLOC (8)
+
+/* Reconnect backoff, in milliseconds */
+#define MCE_RECONNECT_MIN_DELAY (100)
+#define MCE_RECONNECT_MAX_DELAY (30000)
+
+#define SIGNAL_VALID_CHANGED_NAME       "mce-proxy-valid-changed"
+#define SIGNAL_NOKIA_VALID_CHANGED_NAME "mce-proxy-nokia-valid-changed"
+
+static guint mce_proxy_signals[SIGNAL_COUNT] = { 0 };
+static MceProxy* mce_proxy_instance = NULL;
+static gboolean mce_bus_private_on = FALSE;
+static int mce_bus_priority_value = G_PRIORITY_HIGH;
+static MCE_BACKEND mce_bus_backend_choice = MCE_BACKEND_AUTO;
+static const MceBackend* mce_backend = NULL;
+static MceRecorder* mce_recorder = NULL;
+
+static int mce_call_timeout_ms = MCE_CALL_TIMEOUT_DEFAULT;
+static guint mce_call_hedge_percentile = 0;
+static MceCallStats mce_call_stats;
+static MceCallLatency mce_call_latency;
+
+typedef GObjectClass MceProxyClass;
+G_DEFINE_TYPE(MceProxy, mce_proxy, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_proxy_parent_class
+#define MCE_PROXY_TYPE (mce_proxy_get_type())
+#define MCE_PROXY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_PROXY_TYPE,MceProxy))
+
+/*==========================================================================*
+ * Backends
+ *
+ * The parsers are invoked for every signal. g_variant_get_child() would
+ * validate its format string (which allocates), these only take a
+ * reference to the first child of the tuple and read it in place.
+ *==========================================================================*/
+
+static
+gint32
+mce_backend_int_arg(
+    GVariant* args)
+{
+    GVariant* child = g_variant_get_child_value(args, 0);
+    const gint32 value = g_variant_get_int32(child);
+
+    g_variant_unref(child);
+    return value;
+}
+
+static
+const char*
+mce_backend_string_arg(
+    GVariant* args)
+{
+    GVariant* child = g_variant_get_child_value(args, 0);
+    /* The string belongs to args and outlives the child reference */
+    const char* value = g_variant_get_string(child, NULL);
+
+    g_variant_unref(child);
+    return value;
+}
+
+static
+gboolean
+mce_backend_unity_ready(
+    MceProxy* proxy)
+{
+    return proxy->signal && proxy->request;
+}
+
+static
+gpointer
+mce_backend_unity_request(
+    MceProxy* proxy)
+{
+    return proxy->request;
+}
+
+static
+int
+mce_backend_unity_display_state(
+    GVariant* args)
+{
+    /* The signal has (ii) arguments and the reply is (i) */
+    return mce_backend_int_arg(args) ? MCE_DISPLAY_STATE_ON :
+        MCE_DISPLAY_STATE_OFF;
+}
+
+static
+gboolean
+mce_backend_nokia_ready(
+    MceProxy* proxy)
+{
+    return proxy->nokia_request != NULL;
+}
+
+static
+gpointer
+mce_backend_nokia_request(
+    MceProxy* proxy)
+{
+    return proxy->nokia_request;
+}
+
+static
+int
+mce_backend_nokia_display_state(
+    GVariant* args)
+{
+    /* "on", "dimmed" or "off" */
+    const char* state = mce_backend_string_arg(args);
+
+    return g_strcmp0(state, "off") ? MCE_DISPLAY_STATE_ON :
+        MCE_DISPLAY_STATE_OFF;
+}
+
+static
+int
+mce_backend_nokia_tklock_mode(
+    GVariant* args)
+{
+    static const char* modes[] = {
+        "locked",               /* MCE_TKLOCK_MODE_LOCKED */
+        "silent-locked",        /* MCE_TKLOCK_MODE_SILENT_LOCKED */
+        "locked-dim",           /* MCE_TKLOCK_MODE_LOCKED_DIM */
+        "locked-delay",         /* MCE_TKLOCK_MODE_LOCKED_DELAY */
+        "silent-locked-dim",    /* MCE_TKLOCK_MODE_SILENT_LOCKED_DIM */
+        "unlocked",             /* MCE_TKLOCK_MODE_UNLOCKED */
+        "silent-unlocked"       /* MCE_TKLOCK_MODE_SILENT_UNLOCKED */
+    };
+    const char* mode = mce_backend_string_arg(args);
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(modes); i++) {
+        if (!g_strcmp0(mode, modes[i])) {
+            return i;
+        }
+    }
+    GWARN("Unexpected tklock mode %s", mode);
+    return MCE_TKLOCK_MODE_LOCKED;
+}
+
+/* The original interface, implemented by Unity8 and the mce shim */
+static const MceBackend mce_backend_unity = {
+    "unity", MCE_SERVICE, MCE_INTERFACE, MCE_SIGNAL_PATH,
+    mce_backend_unity_ready, mce_backend_unity_request,
+    "DisplayPowerStateChange", "(ii)", "getDisplayPowerState", "(i)",
+    mce_backend_unity_display_state,
+    NULL, NULL, NULL, NULL, NULL
+};
+
+/* Native mce, no shim needed */
+static const MceBackend mce_backend_nokia = {
+    "mce", NOKIA_MCE_SERVICE, NOKIA_MCE_SIGNAL_INTERFACE,
+    NOKIA_MCE_SIGNAL_PATH, mce_backend_nokia_ready, mce_backend_nokia_request,
+    "display_status_ind", "(s)", "get_display_status", "(s)",
+    mce_backend_nokia_display_state,
+    "tklock_mode_ind", "(s)", "get_tklock_mode", "(s)",
+    mce_backend_nokia_tklock_mode
+};
+
+/*==========================================================================*
+ * Recorder
+ *==========================================================================*/
+
+static
+void
+mce_recorder_write(
+    MCE_RECORD_TYPE type,
+    GVariant* payload)
+{
+    MceRecorder* rec = mce_recorder;
+    guint8 header[MCE_RECORD_HEADER_SIZE];
+    const guint64 time = GUINT64_TO_LE(g_get_monotonic_time() - rec->start);
+    GVariant* data = g_variant_ref_sink(payload);
+    guint32 size;
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    GVariant* swapped = g_variant_byteswap(data);
+
+    g_variant_unref(data);
+    data = swapped;
+#endif
+
+    size = GUINT32_TO_LE(g_variant_get_size(data));
+    memcpy(header, &time, 8);
+    memcpy(header + 8, &size, 4);
+    header[12] = (guint8)type;
+    if (fwrite(header, sizeof(header), 1, rec->out) != 1 ||
+        (size && fwrite(g_variant_get_data(data), g_variant_get_size(data),
+        1, rec->out) != 1)) {
+        GWARN("Failed to write MCE recording: %s", strerror(errno));
+        mce_record_stop();
+    }
+    g_variant_unref(data);
+}
+
+static
+void
+mce_recorder_signal(
+    GDBusConnection* bus,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* name,
+    GVariant* args,
+    gpointer arg)
+{
+    if (mce_recorder) {
+        mce_recorder_write(MCE_RECORD_SIGNAL,
+            g_variant_new(MCE_RECORD_SIGNAL_PAYLOAD, iface, name, args));
+    }
+}
+
+static
+void
+mce_recorder_update(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    /* Only subscribe to all signals of both services while recording */
+    if (mce_recorder && self->backend && !priv->record_signal_id) {
+        priv->record_signal_id = g_dbus_connection_signal_subscribe(priv->bus,
+            MCE_SERVICE, MCE_INTERFACE, NULL, MCE_SIGNAL_PATH, NULL,
+            G_DBUS_SIGNAL_FLAGS_NONE, mce_recorder_signal, self, NULL);
+        priv->record_nokia_signal_id = g_dbus_connection_signal_subscribe
+            (priv->bus, NOKIA_MCE_SERVICE, NOKIA_MCE_SIGNAL_INTERFACE, NULL,
+            NOKIA_MCE_SIGNAL_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+            mce_recorder_signal, self, NULL);
+    } else if (!(mce_recorder && self->backend) && priv->record_signal_id) {
+        g_dbus_connection_signal_unsubscribe(priv->bus,
+            priv->record_signal_id);
+        g_dbus_connection_signal_unsubscribe(priv->bus,
+            priv->record_nokia_signal_id);
+        priv->record_signal_id = 0;
+        priv->record_nokia_signal_id = 0;
+    }
+}
+
+/*==========================================================================*
+ * Calls
+ *==========================================================================*/
+
+static
+int
+mce_call_latency_compare(
+    const void* a,
+    const void* b)
+{
+    const guint x = *(const guint*)a;
+    const guint y = *(const guint*)b;
+
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static
+guint
+mce_call_latency_sorted(
+    guint* sorted)
+{
+    const guint n = mce_call_latency.count;
+
+    memcpy(sorted, mce_call_latency.sample, sizeof(sorted[0]) * n);
+    qsort(sorted, n, sizeof(sorted[0]), mce_call_latency_compare);
+    return n;
+}
+
+static
+guint
+mce_call_latency_pick(
+    const guint* sorted,
+    guint n,
+    guint percentile)
+{
+    /* Nearest-rank method */
+    if (n) {
+        const guint rank = (MIN(percentile, 100) * n + 99) / 100;
+
+        return sorted[rank ? (rank - 1) : 0];
+    }
+    return 0;
+}
+
+static
+void
+mce_call_latency_add(
+    gint64 usec)
+{
+    MceCallLatency* lat = &mce_call_latency;
+
+    lat->sample[lat->next] = (guint)MIN(usec, G_MAXUINT);
+    lat->next = (lat->next + 1) % MCE_CALL_LATENCY_SAMPLES;
+    if (lat->count < MCE_CALL_LATENCY_SAMPLES) {
+        lat->count++;
+    }
+}
+
+static
+guint
+mce_proxy_call_hedge_delay(
+    void)
+{
+    if (mce_call_latency.count >= MCE_CALL_HEDGE_MIN_SAMPLES) {
+        return MAX(mce_call_latency_percentile(mce_call_hedge_percentile),
+            MCE_CALL_HEDGE_MIN_DELAY);
+    } else {
+        return MCE_CALL_HEDGE_DEFAULT_DELAY;
+    }
+}
+
+static
+void
+mce_proxy_call_free(
+    MceProxyCall* call)
+{
+    GASSERT(!call->hedge_id);
+    if (call->params) {
+        g_variant_unref(call->params);
+    }
+    g_variant_type_free(call->reply_type);
+    if (call->target) {
+        g_object_unref(call->target);
+    }
+    g_object_unref(call->cancel);
+    g_free(call->method);
+    mce_proxy_unref(call->proxy);
+    g_slice_free(MceProxyCall, call);
+}
+
+static
+void
+mce_proxy_call_issue(
+    MceProxyCall* call,
+    GAsyncReadyCallback done)
+{
+    call->pending++;
+    MCE_TRACE2(call_issue, call->method, call->pending);
+    if (call->target) {
+        /* Timeout is the default one for the request proxy */
+        g_dbus_proxy_call(call->target, call->method,
+            call->params, G_DBUS_CALL_FLAGS_NONE, -1, call->cancel,
+            done, call);
+    } else {
+        GTask* task = g_task_new(NULL, NULL, done, call);
+
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+            "MCE proxy is not initialized");
+        g_object_unref(task);
+    }
+}
+
+static
+void
+mce_proxy_call_finish(
+    GObject* object,
+    GAsyncResult* res,
+    MceProxyCall* call,
+    gboolean hedge)
+{
+    GError* error = NULL;
+    GVariant* result = G_IS_DBUS_PROXY(object) ?
+        g_dbus_proxy_call_finish(G_DBUS_PROXY(object), res, &error) :
+        g_task_propagate_pointer(G_TASK(res), &error);
+
+    GASSERT(call->pending > 0);
+    call->pending--;
+    MCE_TRACE3(call_done, call->method, hedge, result != NULL);
+    if (result && !g_variant_is_of_type(result, call->reply_type)) {
+        g_set_error(&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+            "Unexpected %s reply type %s", call->method,
+            g_variant_get_type_string(result));
+        g_variant_unref(result);
+        result = NULL;
+    }
+
+    /*
+     * If the hedge request is still in flight, failure of this one
+     * is ignored. Whichever successful reply comes first wins.
+     */
+    if (!call->done && (result || !call->pending)) {
+        call->done = TRUE;
+        if (call->hedge_id) {
+            g_source_remove(call->hedge_id);
+            call->hedge_id = 0;
+        }
+        if (result) {
+            mce_call_stats.calls++;
+            if (hedge) {
+                mce_call_stats.hedge_won++;
+            }
+            mce_call_latency_add(g_get_monotonic_time() -
+                (hedge ? call->hedge_start : call->start));
+            if (mce_recorder) {
+                mce_recorder_write(MCE_RECORD_REPLY,
+                    g_variant_new(MCE_RECORD_REPLY_PAYLOAD,
+                    g_dbus_proxy_get_interface_name(call->target),
+                    call->method, result));
+            }
+            /* Cancel the other request, if any */
+            g_cancellable_cancel(call->cancel);
+        } else {
+            GDEBUG("%s failed: %s", call->method, GERRMSG(error));
+            mce_call_stats.failed++;
+        }
+        call->fn(call->proxy, result, error, call->arg);
+    }
+
+    if (result) {
+        g_variant_unref(result);
+    }
+    if (error) {
+        g_error_free(error);
+    }
+    if (!call->pending) {
+        mce_proxy_call_free(call);
+    }
+}
+
+static
+void
+mce_proxy_call_done(
+    GObject* object,
+    GAsyncResult* res,
+    gpointer arg)
+{
+    mce_proxy_call_finish(object, res, arg, FALSE);
+}
+
+static
+void
+mce_proxy_call_hedge_done(
+    GObject* object,
+    GAsyncResult* res,
+    gpointer arg)
+{
+    mce_proxy_call_finish(object, res, arg, TRUE);
+}
+
+static
+gboolean
+mce_proxy_call_hedge(
+    gpointer arg)
+{
+    MceProxyCall* call = arg;
+
+    GDEBUG("Hedging %s", call->method);
+    call->hedge_id = 0;
+    call->hedge_start = g_get_monotonic_time();
+    mce_call_stats.hedged++;
+    mce_proxy_call_issue(call, mce_proxy_call_hedge_done);
+    return G_SOURCE_REMOVE;
+}
+
+/*==========================================================================*
+ * Private connection
+ *
+ * GDBus delivers signals to the main context at the default priority,
+ * behind whatever else is queued there. On the private connection a
+ * filter picks backend signals right in the GDBus worker thread
+ * and hands them over to our own source, which is dispatched at the
+ * priority given to mce_bus_set_priority().
+ *==========================================================================*/
+
+static
+GDBusMessage*
+mce_signal_filter(
+    GDBusConnection* bus,
+    GDBusMessage* message,
+    gboolean incoming,
+    gpointer user_data)
+{
+    MceSignalSource* src = user_data;
+    const MceBackend* backend = src->backend;
+
+    if (incoming &&
+        g_dbus_message_get_message_type(message) ==
+        G_DBUS_MESSAGE_TYPE_SIGNAL &&
+        !g_strcmp0(g_dbus_message_get_interface(message),
+            backend->signal_interface) &&
+        !g_strcmp0(g_dbus_message_get_path(message), backend->signal_path)) {
+        g_mutex_lock(&src->mutex);
+        g_queue_push_tail(&src->messages, g_object_ref(message));
+        g_mutex_unlock(&src->mutex);
+        /* This is thread safe and wakes up the main context */
+        g_source_set_ready_time(&src->source, 0);
+    }
+    return message;
+}
+
+static
+void
+mce_signal_sub_unref(
+    gpointer data)
+{
+    MceSignalSub* sub = data;
+
+    if (!--sub->ref_count) {
+        g_free(sub->member);
+        g_slice_free(MceSignalSub, sub);
+    }
+}
+
+static
+void
+mce_signal_sub_drop(
+    gpointer data)
+{
+    MceSignalSub* sub = data;
+
+    /* It may still be in the middle of being dispatched */
+    sub->id = 0;
+    mce_signal_sub_unref(sub);
+}
+
+static
+gboolean
+mce_signal_source_dispatch(
+    GSource* source,
+    GSourceFunc callback,
+    gpointer user_data)
+{
+    MceSignalSource* src = (MceSignalSource*)source;
+    const MceBackend* backend = src->backend;
+    MceProxy* self = src->proxy;
+    GQueue messages = G_QUEUE_INIT;
+    GDBusMessage* message;
+
+    g_source_set_ready_time(source, -1);
+    g_mutex_lock(&src->mutex);
+    messages = src->messages;
+    g_queue_init(&src->messages);
+    g_mutex_unlock(&src->mutex);
+
+    /* Handlers may drop the last reference, or even the bus */
+    if (self) {
+        g_object_ref(self);
+    }
+    while ((message = g_queue_pop_head(&messages)) != NULL) {
+        const char* sender = g_dbus_message_get_sender(message);
+
+        /*
+         * The match rule only keeps out broadcasts from the others.
+         * Signals sent directly to us get through regardless, so like
+         * GDBus does for its subscriptions, we check the sender.
+         */
+        if (self && self->priv->bus && self->priv->owner &&
+            !g_strcmp0(sender, self->priv->owner)) {
+            MceProxyPriv* priv = self->priv;
+            GDBusConnection* bus = g_object_ref(priv->bus);
+            const char* member = g_dbus_message_get_member(message);
+            MceSignalSub* buf[MCE_SIGNAL_SUBS_PREALLOC];
+            MceSignalSub** subs = buf;
+            guint i, n = 0;
+            GSList* l;
+
+            /*
+             * Handlers may (un)subscribe, hence the snapshot. It lives
+             * on the stack unless there are too many subscribers, this
+             * path is not supposed to allocate (see mce_bus.h)
+             */
+            for (l = priv->subs; l; l = l->next) {
+                MceSignalSub* sub = l->data;
+
+                if (!g_strcmp0(sub->member, member)) {
+                    n++;
+                }
+            }
+            if (n > G_N_ELEMENTS(buf)) {
+                subs = g_new(MceSignalSub*, n);
+            }
+            for (n = 0, l = priv->subs; l; l = l->next) {
+                MceSignalSub* sub = l->data;
+
+                if (!g_strcmp0(sub->member, member)) {
+                    sub->ref_count++;
+                    subs[n++] = sub;
+                }
+            }
+            for (i = 0; i < n; i++) {
+                MceSignalSub* sub = subs[i];
+
+                if (sub->id) {
+                    sub->fn(bus, sender, backend->signal_path,
+                        backend->signal_interface, member,
+                        g_dbus_message_get_body(message), sub->arg);
+                }
+            }
+            for (i = 0; i < n; i++) {
+                mce_signal_sub_unref(subs[i]);
+            }
+            if (subs != buf) {
+                g_free(subs);
+            }
+            g_object_unref(bus);
+        }
+        g_object_unref(message);
+    }
+    if (self) {
+        g_object_unref(self);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static
+void
+mce_signal_source_finalize(
+    GSource* source)
+{
+    MceSignalSource* src = (MceSignalSource*)source;
+
+    g_queue_clear_full(&src->messages, g_object_unref);
+    g_mutex_clear(&src->mutex);
+}
+
+static
+void
+mce_signal_source_attach(
+    MceProxy* self)
+{
+    static GSourceFuncs mce_signal_source_funcs = {
+        NULL, NULL,
+        mce_signal_source_dispatch,
+        mce_signal_source_finalize
+    };
+    MceProxyPriv* priv = self->priv;
+    const MceBackend* backend = self->backend;
+    GSource* source = g_source_new(&mce_signal_source_funcs,
+        sizeof(MceSignalSource));
+    MceSignalSource* src = (MceSignalSource*)source;
+    char* match = g_strdup_printf("type='signal',sender='%s',"
+        "interface='%s',path='%s'", backend->service,
+        backend->signal_interface, backend->signal_path);
+
+    src->backend = backend;
+    g_mutex_init(&src->mutex);
+    g_queue_init(&src->messages);
+    src->proxy = self;
+    g_source_set_priority(source, mce_bus_priority_value);
+    g_source_set_name(source, "mce-signals");
+    g_source_attach(source, NULL);
+    priv->signal_source = src;
+
+    /* The filter holds its own reference, it may outlive the proxy */
+    priv->filter_id = g_dbus_connection_add_filter(priv->bus,
+        mce_signal_filter, g_source_ref(source),
+        (GDestroyNotify) g_source_unref);
+    g_dbus_connection_call(priv->bus, "org.freedesktop.DBus",
+        "/org/freedesktop/DBus", "org.freedesktop.DBus", "AddMatch",
+        g_variant_new("(s)", match), NULL,
+        G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+    g_free(match);
+}
+
+static
+void
+mce_signal_source_detach(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (priv->signal_source) {
+        GSource* source = &priv->signal_source->source;
+
+        g_dbus_connection_remove_filter(priv->bus, priv->filter_id);
+        priv->filter_id = 0;
+        priv->signal_source->proxy = NULL;
+        priv->signal_source = NULL;
+        g_source_destroy(source);
+        g_source_unref(source);
+    }
+}
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_name_appeared(
+    GDBusConnection* bus,
+    const gchar* name,
+    const gchar* owner,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+
+    MCE_TRACE1(name_appeared, owner);
+    GDEBUG("Name '%s' is owned by %s", name, owner);
+    if (mce_recorder) {
+        mce_recorder_write(MCE_RECORD_NAME_APPEARED,
+            g_variant_new(MCE_RECORD_NAME_APPEARED_PAYLOAD, name, owner));
+    }
+    GASSERT(!self->valid);
+    if (!mce_backend) {
+        /* Detection was inconclusive, this one is here to stay */
+        mce_backend = self->backend;
+    }
+    if (self->priv->lost_time) {
+        mce_call_stats.recovery = (guint)(g_get_monotonic_time() -
+            self->priv->lost_time);
+        self->priv->lost_time = 0;
+        GDEBUG("Recovered in %u ms", mce_call_stats.recovery / 1000);
+    }
+    g_free(self->priv->owner);
+    self->priv->owner = g_strdup(owner);
+    self->valid = TRUE;
+    g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+}
+
+static
+void
+mce_name_vanished(
+    GDBusConnection* bus,
+    const gchar* name,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+
+    MCE_TRACE0(name_vanished);
+    GDEBUG("Name '%s' has disappeared", name);
+    if (mce_recorder) {
+        mce_recorder_write(MCE_RECORD_NAME_VANISHED,
+            g_variant_new(MCE_RECORD_NAME_VANISHED_PAYLOAD, name));
+    }
+    g_free(self->priv->owner);
+    self->priv->owner = NULL;
+    if (self->valid) {
+        self->valid = FALSE;
+        g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+gboolean
+mce_proxy_reselect(
+    gpointer arg);
+
+static
+void
+mce_nokia_name_appeared(
+    GDBusConnection* bus,
+    const gchar* name,
+    const gchar* owner,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    MceProxyPriv* priv = self->priv;
+
+    GDEBUG("Name '%s' is owned by %s", name, owner);
+    if (mce_recorder && g_strcmp0(self->backend->service, name)) {
+        mce_recorder_write(MCE_RECORD_NAME_APPEARED,
+            g_variant_new(MCE_RECORD_NAME_APPEARED_PAYLOAD, name, owner));
+    }
+    GASSERT(!self->nokia_valid);
+    self->nokia_valid = TRUE;
+    g_signal_emit(self, mce_proxy_signals[SIGNAL_NOKIA_VALID_CHANGED], 0);
+    if (!mce_backend && self->backend != &mce_backend_nokia) {
+        /* Native mce has shown up first, no Unity.Screen shim then */
+        mce_backend = &mce_backend_nokia;
+        if (!priv->reconnect_id) {
+            priv->reconnect_id = g_idle_add(mce_proxy_reselect, self);
+        }
+    }
+}
+
+static
+void
+mce_nokia_name_vanished(
+    GDBusConnection* bus,
+    const gchar* name,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+
+    GDEBUG("Name '%s' has disappeared", name);
+    if (mce_recorder && g_strcmp0(self->backend->service, name)) {
+        mce_recorder_write(MCE_RECORD_NAME_VANISHED,
+            g_variant_new(MCE_RECORD_NAME_VANISHED_PAYLOAD, name));
+    }
+    if (self->nokia_valid) {
+        self->nokia_valid = FALSE;
+        g_signal_emit(self, mce_proxy_signals[SIGNAL_NOKIA_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_proxy_init_check(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    const MceBackend* backend = self->backend;
+
+    if (backend->ready(self) && self->nokia_signal && self->nokia_request) {
+        /* Connected, start from the shortest delay next time */
+        priv->reconnect_delay = 0;
+    }
+    if (backend->ready(self) && !priv->mce_watch_id) {
+        priv->mce_watch_id = g_bus_watch_name_on_connection(priv->bus,
+            backend->service, G_BUS_NAME_WATCHER_FLAGS_NONE,
+            mce_name_appeared, mce_name_vanished, self, NULL);
+    }
+    if (self->nokia_signal && self->nokia_request && !priv->nokia_watch_id) {
+        priv->nokia_watch_id = g_bus_watch_name_on_connection(priv->bus,
+            NOKIA_MCE_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE,
+            mce_nokia_name_appeared, mce_nokia_name_vanished, self, NULL);
+    }
+}
+
+static
+gpointer
+mce_proxy_check_new(
+    MceProxy* self,
+    gpointer proxy,
+    GError* error,
+    const char* what)
+{
+    if (proxy) {
+        if (g_dbus_proxy_get_connection(G_DBUS_PROXY(proxy)) ==
+            self->priv->bus) {
+            return proxy;
+        }
+        /* The connection has been lost while the proxy was created */
+        g_object_unref(proxy);
+    } else {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            GERR("Failed to initialize %s proxy: %s", what, GERRMSG(error));
+        }
+        g_error_free(error);
+    }
+    return NULL;
+}
+
+static
+void
+mce_proxy_request_proxy_new_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    GError* error = NULL;
+    ComCanonicalUnityScreen* proxy =
+        com_canonical_unity_screen_proxy_new_finish(result, &error);
+
+    GASSERT(!self->request);
+    self->request = mce_proxy_check_new(self, proxy, error, "MCE request");
+    if (self->request) {
+        g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(self->request),
+            mce_call_timeout_ms);
+        mce_proxy_init_check(self);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_signal_proxy_new_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    GError* error = NULL;
+    ComCanonicalUnityScreen* proxy =
+        com_canonical_unity_screen_proxy_new_finish(result, &error);
+
+    GASSERT(!self->signal);
+    self->signal = mce_proxy_check_new(self, proxy, error, "MCE signal");
+    if (self->signal) {
+        mce_proxy_init_check(self);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_nokia_request_proxy_new_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    GError* error = NULL;
+    ComNokiaMceRequest* proxy =
+        com_nokia_mce_request_proxy_new_finish(result, &error);
+
+    GASSERT(!self->nokia_request);
+    self->nokia_request = mce_proxy_check_new(self, proxy, error,
+        NOKIA_MCE_REQUEST_INTERFACE);
+    if (self->nokia_request) {
+        g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(self->nokia_request),
+            mce_call_timeout_ms);
+        mce_proxy_init_check(self);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_nokia_signal_proxy_new_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    GError* error = NULL;
+    ComNokiaMceSignal* proxy =
+        com_nokia_mce_signal_proxy_new_finish(result, &error);
+
+    GASSERT(!self->nokia_signal);
+    self->nokia_signal = mce_proxy_check_new(self, proxy, error,
+        NOKIA_MCE_SIGNAL_INTERFACE);
+    if (self->nokia_signal) {
+        mce_proxy_init_check(self);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_drop_bus(
+    MceProxy* self,
+    gboolean notify)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (priv->cancel) {
+        g_cancellable_cancel(priv->cancel);
+        g_object_unref(priv->cancel);
+        priv->cancel = NULL;
+    }
+    if (priv->mce_watch_id) {
+        g_bus_unwatch_name(priv->mce_watch_id);
+        priv->mce_watch_id = 0;
+    }
+    if (priv->nokia_watch_id) {
+        g_bus_unwatch_name(priv->nokia_watch_id);
+        priv->nokia_watch_id = 0;
+    }
 
-GLOG_MODULE_DEFINE("mce");
+    /*
+     * Invalidate while the proxies are still alive, so that the
+     * valid handlers get a chance to disconnect from their signals.
+     * Signals may have been subscribed to while the service was
+     * absent, so the handlers are notified even if nothing was valid.
+     */
+    self->valid = self->nokia_valid = FALSE;
+    g_free(priv->owner);
+    priv->owner = NULL;
+    if (notify && priv->bus) {
+        g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+        g_signal_emit(self, mce_proxy_signals[SIGNAL_NOKIA_VALID_CHANGED], 0);
+    }
+    /* Whatever is still subscribed, doesn't survive reconnect */
+    g_slist_free_full(priv->subs, mce_signal_sub_drop);
+    priv->subs = NULL;
+    if (self->nokia_signal) {
+        g_object_unref(self->nokia_signal);
+        self->nokia_signal = NULL;
+    }
+    if (self->nokia_request) {
+        g_object_unref(self->nokia_request);
+        self->nokia_request = NULL;
+    }
+    if (priv->record_signal_id) {
+        g_dbus_connection_signal_unsubscribe(priv->bus,
+            priv->record_signal_id);
+        g_dbus_connection_signal_unsubscribe(priv->bus,
+            priv->record_nokia_signal_id);
+        priv->record_signal_id = 0;
+        priv->record_nokia_signal_id = 0;
+    }
+    if (self->signal) {
+        g_object_unref(self->signal);
+        self->signal = NULL;
+    }
+    if (self->request) {
+        g_object_unref(self->request);
+        self->request = NULL;
+    }
+    self->backend = NULL;
+    if (priv->bus) {
+        g_signal_handler_disconnect(priv->bus, priv->bus_closed_id);
+        priv->bus_closed_id = 0;
+        if (priv->signal_source) {
+            /* Nobody else is using our private connection */
+            mce_signal_source_detach(self);
+            g_dbus_connection_close(priv->bus, NULL, NULL, NULL);
+        }
+        g_object_unref(priv->bus);
+        priv->bus = NULL;
+    }
+}
 
-struct mce_proxy_priv {
-    GDBusConnection* bus;
-    guint mce_watch_id;
-};
+static
+void
+mce_proxy_bus_get_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg);
 
-enum mce_proxy_signal {
-    SIGNAL_VALID_CHANGED,
-    SIGNAL_COUNT
-};
+static
+void
+mce_proxy_bus_new_finished(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer arg);
 
-#define SIGNAL_VALID_CHANGED_NAME   "mce-proxy-valid-changed"
+static
+void
+mce_proxy_bus_attach(
+    MceProxy* self,
+    GDBusConnection* bus,
+    gboolean own,
+    GError* error);
 
-#define MCE_SERVICE "com.canonical.Unity.Screen"
-#define MCE_REQUEST_PATH "/com/canonical/Unity/Screen"
-#define MCE_SIGNAL_PATH "/com/canonical/Unity/Screen"
+static
+void
+mce_proxy_connect(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
 
-static guint mce_proxy_signals[SIGNAL_COUNT] = { 0 };
+    GASSERT(!priv->cancel);
+    priv->cancel = g_cancellable_new();
 
-typedef GObjectClass MceProxyClass;
-G_DEFINE_TYPE(MceProxy, mce_proxy, G_TYPE_OBJECT)
-#define PARENT_CLASS mce_proxy_parent_class
-#define MCE_PROXY_TYPE (mce_proxy_get_type())
-#define MCE_PROXY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
-        MCE_PROXY_TYPE,MceProxy))
+    /*
+     * GLib keeps handing out the shared connection (even a closed one)
+     * for as long as anyone in the process holds a reference to it.
+     * Once it has been lost, we connect on our own.
+     */
+    if (mce_bus_private_on || priv->shared_lost) {
+        GError* error = NULL;
+        char* address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SYSTEM,
+            priv->cancel, &error);
+
+        if (address) {
+            g_dbus_connection_new_for_address(address,
+                G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION, NULL,
+                priv->cancel, mce_proxy_bus_new_finished,
+                mce_proxy_ref(self));
+            g_free(address);
+            return;
+        } else if (priv->shared_lost) {
+            mce_proxy_bus_attach(self, NULL, TRUE, error);
+            return;
+        }
+        GWARN("Using shared connection: %s", GERRMSG(error));
+        g_error_free(error);
+    }
+    g_bus_get(G_BUS_TYPE_SYSTEM, priv->cancel, mce_proxy_bus_get_finished,
+        mce_proxy_ref(self));
+}
+
+static
+gboolean
+mce_proxy_reconnect(
+    gpointer arg)
+{
+    MceProxy* self = MCE_PROXY(arg);
+    MceProxyPriv* priv = self->priv;
+
+    GDEBUG("Reconnecting to system bus");
+    priv->reconnect_id = 0;
+    mce_call_stats.reconnects++;
+    mce_proxy_connect(self);
+    return G_SOURCE_REMOVE;
+}
 
 static
 void
-mce_name_appeared(
-    GDBusConnection* bus,
-    const gchar* name,
-    const gchar* owner,
+mce_proxy_reconnect_schedule(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (!priv->reconnect_id) {
+        /* The first attempt is made right away */
+        const guint delay = priv->reconnect_delay;
+
+        priv->reconnect_delay = delay ? MIN(delay * 2,
+            MCE_RECONNECT_MAX_DELAY) : MCE_RECONNECT_MIN_DELAY;
+        priv->reconnect_id = delay ? g_timeout_add(delay,
+            mce_proxy_reconnect, self) : g_idle_add(mce_proxy_reconnect, self);
+    }
+}
+
+static
+gboolean
+mce_proxy_reselect(
     gpointer arg)
 {
     MceProxy* self = MCE_PROXY(arg);
 
-    GDEBUG("Name '%s' is owned by %s", name, owner);
-    GASSERT(!self->valid);
-    self->valid = TRUE;
-    g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    GDEBUG("Switching to %s backend", mce_backend->name);
+    self->priv->reconnect_id = 0;
+    mce_proxy_drop_bus(self, TRUE);
+    mce_proxy_connect(self);
+    return G_SOURCE_REMOVE;
 }
 
 static
 void
-mce_name_vanished(
+mce_proxy_bus_closed(
     GDBusConnection* bus,
-    const gchar* name,
+    gboolean remote_peer_vanished,
+    GError* error,
     gpointer arg)
 {
     MceProxy* self = MCE_PROXY(arg);
+    MceProxyPriv* priv = self->priv;
 
-    GDEBUG("Name '%s' has disappeared", name);
-    if (self->valid) {
-        self->valid = FALSE;
-        g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    GWARN("System bus connection lost: %s", error ? GERRMSG(error) :
+        "closed");
+    if (!priv->bus_own) {
+        priv->shared_lost = TRUE;
     }
+    if (!priv->lost_time) {
+        priv->lost_time = g_get_monotonic_time();
+    }
+    mce_proxy_drop_bus(self, TRUE);
+    mce_proxy_reconnect_schedule(self);
 }
 
 static
 void
-mce_proxy_init_check(
-    MceProxy* self)
+mce_proxy_bus_ready(
+    MceProxy* self,
+    const MceBackend* backend)
 {
     MceProxyPriv* priv = self->priv;
+    GDBusConnection* bus = priv->bus;
+    GCancellable* cancel = priv->cancel;
 
-    if (self->signal && self->request && !priv->mce_watch_id) {
-        priv->mce_watch_id = g_bus_watch_name_on_connection(priv->bus,
-            MCE_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE,
-            mce_name_appeared, mce_name_vanished, self, NULL);
+    GDEBUG("Using %s backend", backend->name);
+    self->backend = backend;
+    if (priv->bus_own) {
+        mce_signal_source_attach(self);
+    }
+    mce_recorder_update(self);
+    if (backend == &mce_backend_unity) {
+        /*
+         * Unity.Screen signals are delivered straight from the
+         * connection (see mce_proxy_subscribe), bypassing GDBusProxy
+         * and the generated code which would unpack each of them
+         * into a freshly allocated GValue array. The request path is
+         * the same as the signal one, so the request proxy must not
+         * be listening either.
+         */
+        com_canonical_unity_screen_proxy_new(bus,
+            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+            G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+            MCE_SERVICE, MCE_REQUEST_PATH, cancel,
+            mce_proxy_request_proxy_new_finished,
+            mce_proxy_ref(self));
+        com_canonical_unity_screen_proxy_new(bus,
+            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+            G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+            MCE_SERVICE, MCE_SIGNAL_PATH, cancel,
+            mce_proxy_signal_proxy_new_finished,
+            mce_proxy_ref(self));
     }
+    com_nokia_mce_request_proxy_new(bus,
+        G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+        NOKIA_MCE_SERVICE, NOKIA_MCE_REQUEST_PATH, cancel,
+        mce_proxy_nokia_request_proxy_new_finished,
+        mce_proxy_ref(self));
+    com_nokia_mce_signal_proxy_new(bus,
+        G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+        NOKIA_MCE_SERVICE, NOKIA_MCE_SIGNAL_PATH, cancel,
+        mce_proxy_nokia_signal_proxy_new_finished,
+        mce_proxy_ref(self));
 }
 
 static
 void
-mce_proxy_request_proxy_new_finished(
-    GObject* object,
+mce_proxy_backend_detected(
+    GObject* bus,
     GAsyncResult* result,
     gpointer arg)
 {
     MceProxy* self = MCE_PROXY(arg);
+    MceProxyPriv* priv = self->priv;
     GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(bus),
+        result, &error);
 
-    GASSERT(!self->request);
-    self->request = com_canonical_unity_screen_proxy_new_finish(result, &error);
-    if (self->request) {
-        mce_proxy_init_check(self);
-    } else {
-        GERR("Failed to initialize MCE request proxy: %s", GERRMSG(error));
+    if (reply) {
+        const char** names = NULL;
+
+        g_variant_get(reply, "(^a&s)", &names);
+        if (!mce_backend) {
+            /*
+             * Native mce wins if it's there, so that nobody pays for
+             * the Unity.Screen shim running on top of it. The shim is
+             * the fallback. If neither is running (yet) we start with
+             * Unity.Screen and settle on whichever name shows up first,
+             * see mce_name_appeared() and mce_nokia_name_appeared().
+             */
+            if (g_strv_contains(names, NOKIA_MCE_SERVICE)) {
+                mce_backend = &mce_backend_nokia;
+            } else if (g_strv_contains(names, MCE_SERVICE)) {
+                mce_backend = &mce_backend_unity;
+            }
+        }
+        g_free(names);
+        g_variant_unref(reply);
+    } else if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        GWARN("Failed to detect MCE backend: %s", GERRMSG(error));
+    }
+    if (priv->cancel && !g_cancellable_is_cancelled(priv->cancel) &&
+        priv->bus == G_DBUS_CONNECTION(bus)) {
+        mce_proxy_bus_ready(self, mce_backend ? mce_backend :
+            &mce_backend_unity);
+    }
+    if (error) {
         g_error_free(error);
     }
     mce_proxy_unref(self);
@@ -136,52 +1360,93 @@ mce_proxy_request_proxy_new_finished(
 
 static
 void
-mce_proxy_signal_proxy_new_finished(
+mce_proxy_bus_attach(
+    MceProxy* self,
+    GDBusConnection* bus,
+    gboolean own,
+    GError* error)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (bus && (!priv->cancel || g_cancellable_is_cancelled(priv->cancel))) {
+        /* Finalized or dropped in the meantime */
+        g_object_unref(bus);
+    } else if (bus) {
+        /*
+         * Connections of our own don't exit on close, we reconnect.
+         * The exit-on-close behavior of the shared connection is up
+         * to the application, we are not the only user of it.
+         */
+        priv->bus = bus;
+        priv->bus_own = own;
+        priv->bus_closed_id = g_signal_connect(bus, "closed",
+            G_CALLBACK(mce_proxy_bus_closed), self);
+        if (!mce_backend) {
+            switch (mce_bus_backend_choice) {
+            case MCE_BACKEND_UNITY:
+                mce_backend = &mce_backend_unity;
+                break;
+            case MCE_BACKEND_NOKIA:
+                mce_backend = &mce_backend_nokia;
+                break;
+            case MCE_BACKEND_AUTO:
+                break;
+            }
+        }
+        if (mce_backend) {
+            mce_proxy_bus_ready(self, mce_backend);
+        } else {
+            g_dbus_connection_call(bus, "org.freedesktop.DBus",
+                "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                "ListNames", NULL, G_VARIANT_TYPE("(as)"),
+                G_DBUS_CALL_FLAGS_NONE, -1, priv->cancel,
+                mce_proxy_backend_detected, mce_proxy_ref(self));
+        }
+        if (g_dbus_connection_is_closed(bus)) {
+            /* A closed shared connection, "closed" would never come */
+            mce_proxy_bus_closed(bus, FALSE, NULL, self);
+        }
+    } else {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            GERR("Failed to attach to system bus: %s", GERRMSG(error));
+            if (priv->cancel) {
+                g_object_unref(priv->cancel);
+                priv->cancel = NULL;
+                mce_proxy_reconnect_schedule(self);
+            }
+        }
+        g_error_free(error);
+    }
+}
+
+static
+void
+mce_proxy_bus_get_finished(
     GObject* object,
     GAsyncResult* result,
     gpointer arg)
 {
     MceProxy* self = MCE_PROXY(arg);
     GError* error = NULL;
+    GDBusConnection* bus = g_bus_get_finish(result, &error);
 
-    GASSERT(!self->signal);
-    self->signal = com_canonical_unity_screen_proxy_new_finish(result, &error);
-    if (self->signal) {
-        mce_proxy_init_check(self);
-    } else {
-        GERR("Failed to initialize MCE signal proxy: %s", GERRMSG(error));
-        g_error_free(error);
-    }
+    mce_proxy_bus_attach(self, bus, FALSE, error);
     mce_proxy_unref(self);
 }
 
 static
 void
-mce_proxy_bus_get_finished(
+mce_proxy_bus_new_finished(
     GObject* object,
     GAsyncResult* result,
     gpointer arg)
 {
     MceProxy* self = MCE_PROXY(arg);
-    MceProxyPriv* priv = self->priv;
     GError* error = NULL;
+    GDBusConnection* bus = g_dbus_connection_new_for_address_finish(result,
+        &error);
 
-    priv->bus = g_bus_get_finish(result, &error);
-    if (priv->bus) {
-        com_canonical_unity_screen_proxy_new(priv->bus,
-            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
-            MCE_SERVICE, MCE_REQUEST_PATH, NULL,
-            mce_proxy_request_proxy_new_finished,
-            mce_proxy_ref(self));
-        com_canonical_unity_screen_proxy_new(priv->bus,
-            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
-            MCE_SERVICE, MCE_SIGNAL_PATH, NULL,
-            mce_proxy_signal_proxy_new_finished,
-            mce_proxy_ref(self));
-    } else {
-        GERR("Failed to attach to system bus: %s", GERRMSG(error));
-        g_error_free(error);
-    }
+    mce_proxy_bus_attach(self, bus, TRUE, error);
     mce_proxy_unref(self);
 }
 
@@ -192,13 +1457,13 @@ mce_proxy_new()
      * Since there's only one mce in the system, there's no need for
      * more than one proxy object.
      */
-    static MceProxy* mce_proxy_instance = NULL;
     if (mce_proxy_instance) {
-        mce_proxy_ref(mce_proxy_instance);
+        if (!mce_linger_revive(mce_proxy_instance)) {
+            mce_proxy_ref(mce_proxy_instance);
+        }
     } else {
         mce_proxy_instance = g_object_new(MCE_PROXY_TYPE, NULL);
-        g_bus_get(G_BUS_TYPE_SYSTEM, NULL, mce_proxy_bus_get_finished,
-            mce_proxy_ref(mce_proxy_instance));
+        mce_proxy_connect(mce_proxy_instance);
         g_object_add_weak_pointer(G_OBJECT(mce_proxy_instance),
             (gpointer*)(&mce_proxy_instance));
     }
@@ -219,7 +1484,7 @@ void
 mce_proxy_unref(
     MceProxy* self)
 {
-    if (G_LIKELY(self)) {
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
         g_object_unref(MCE_PROXY(self));
     }
 }
@@ -234,6 +1499,16 @@ mce_proxy_add_valid_changed_handler(
         SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
 }
 
+gulong
+mce_proxy_add_nokia_valid_changed_handler(
+    MceProxy* self,
+    MceProxyFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
+        SIGNAL_NOKIA_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
 void
 mce_proxy_remove_handler(
     MceProxy* self,
@@ -244,6 +1519,267 @@ mce_proxy_remove_handler(
     }
 }
 
+guint
+mce_proxy_subscribe(
+    MceProxy* self,
+    const char* member,
+    GDBusSignalCallback fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn) && self->backend) {
+        MceProxyPriv* priv = self->priv;
+
+        if (priv->signal_source) {
+            MceSignalSub* sub = g_slice_new(MceSignalSub);
+
+            sub->ref_count = 1;
+            sub->id = ++priv->last_sub_id;
+            sub->member = g_strdup(member);
+            sub->fn = fn;
+            sub->arg = arg;
+            priv->subs = g_slist_append(priv->subs, sub);
+            return sub->id;
+        } else {
+            const MceBackend* backend = self->backend;
+
+            return g_dbus_connection_signal_subscribe(priv->bus,
+                backend->service, backend->signal_interface, member,
+                backend->signal_path, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+                fn, arg, NULL);
+        }
+    }
+    return 0;
+}
+
+void
+mce_proxy_unsubscribe(
+    MceProxy* self,
+    guint id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxyPriv* priv = self->priv;
+
+        GASSERT(priv->bus);
+        if (priv->signal_source) {
+            GSList* l;
+
+            for (l = priv->subs; l; l = l->next) {
+                MceSignalSub* sub = l->data;
+
+                if (sub->id == id) {
+                    priv->subs = g_slist_delete_link(priv->subs, l);
+                    mce_signal_sub_drop(sub);
+                    break;
+                }
+            }
+        } else {
+            g_dbus_connection_signal_unsubscribe(priv->bus, id);
+        }
+    }
+}
+
+void
+mce_proxy_call(
+    MceProxy* self,
+    gpointer target,
+    const char* method,
+    GVariant* params,
+    const GVariantType* reply_type,
+    MceProxyCallFunc fn,
+    void* arg)
+{
+    MceProxyCall* call = g_slice_new0(MceProxyCall);
+
+    call->proxy = mce_proxy_ref(self);
+    call->target = target ? g_object_ref(target) : NULL;
+    call->method = g_strdup(method);
+    call->params = params ? g_variant_ref_sink(params) : NULL;
+    call->reply_type = g_variant_type_copy(reply_type);
+    call->fn = fn;
+    call->arg = arg;
+    call->cancel = g_cancellable_new();
+    call->start = g_get_monotonic_time();
+    mce_proxy_call_issue(call, mce_proxy_call_done);
+    if (mce_call_hedge_percentile) {
+        call->hedge_id = g_timeout_add((mce_proxy_call_hedge_delay() + 999) /
+            1000, mce_proxy_call_hedge, call);
+    }
+}
+
+/*==========================================================================*
+ * Recorder API
+ *==========================================================================*/
+
+gboolean
+mce_record_start(
+    const char* path,
+    GError** error)
+{
+    FILE* out = fopen(path, "wb");
+
+    if (out) {
+        if (fwrite(MCE_RECORD_MAGIC, MCE_RECORD_MAGIC_SIZE, 1, out) == 1) {
+            mce_record_stop();
+            mce_recorder = g_new0(MceRecorder, 1);
+            mce_recorder->out = out;
+            mce_recorder->start = g_get_monotonic_time();
+            if (mce_proxy_instance) {
+                mce_recorder_update(mce_proxy_instance);
+            }
+            GDEBUG("Recording MCE traffic to %s", path);
+            return TRUE;
+        }
+        fclose(out);
+    }
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+        "%s: %s", path, strerror(errno));
+    return FALSE;
+}
+
+void
+mce_record_stop(
+    void)
+{
+    if (mce_recorder) {
+        MceRecorder* rec = mce_recorder;
+
+        mce_recorder = NULL;
+        fclose(rec->out);
+        g_free(rec);
+        if (mce_proxy_instance) {
+            mce_recorder_update(mce_proxy_instance);
+        }
+    }
+}
+
+/*==========================================================================*
+ * Bus API
+ *==========================================================================*/
+
+void
+mce_bus_set_private(
+    gboolean enabled)
+{
+    mce_bus_private_on = enabled;
+}
+
+gboolean
+mce_bus_private(
+    void)
+{
+    return mce_bus_private_on;
+}
+
+void
+mce_bus_set_priority(
+    int priority)
+{
+    mce_bus_priority_value = priority;
+}
+
+int
+mce_bus_priority(
+    void)
+{
+    return mce_bus_priority_value;
+}
+
+void
+mce_bus_set_backend(
+    MCE_BACKEND backend)
+{
+    if (mce_bus_backend_choice != backend) {
+        mce_bus_backend_choice = backend;
+        mce_backend = NULL;
+    }
+}
+
+MCE_BACKEND
+mce_bus_backend(
+    void)
+{
+    return mce_bus_backend_choice;
+}
+
+/*==========================================================================*
+ * Call API
+ *==========================================================================*/
+
+void
+mce_call_set_timeout(
+    int timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_instance;
+
+    mce_call_timeout_ms = (timeout_ms > 0) ? timeout_ms :
+        MCE_CALL_TIMEOUT_DEFAULT;
+    if (proxy && proxy->request) {
+        g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(proxy->request),
+            mce_call_timeout_ms);
+    }
+    if (proxy && proxy->nokia_request) {
+        g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(proxy->nokia_request),
+            mce_call_timeout_ms);
+    }
+}
+
+int
+mce_call_timeout(
+    void)
+{
+    return mce_call_timeout_ms;
+}
+
+void
+mce_call_set_hedging(
+    guint percentile)
+{
+    mce_call_hedge_percentile = MIN(percentile, 100);
+}
+
+guint
+mce_call_hedging(
+    void)
+{
+    return mce_call_hedge_percentile;
+}
+
+void
+mce_call_get_stats(
+    MceCallStats* stats)
+{
+    if (G_LIKELY(stats)) {
+        guint sorted[MCE_CALL_LATENCY_SAMPLES];
+        const guint n = mce_call_latency_sorted(sorted);
+
+        *stats = mce_call_stats;
+        stats->samples = n;
+        if (n) {
+            stats->latency_min = sorted[0];
+            stats->latency_p50 = mce_call_latency_pick(sorted, n, 50);
+            stats->latency_p90 = mce_call_latency_pick(sorted, n, 90);
+            stats->latency_p99 = mce_call_latency_pick(sorted, n, 99);
+            stats->latency_max = sorted[n - 1];
+        }
+        stats->hedge_delay = mce_call_hedge_percentile ?
+            mce_proxy_call_hedge_delay() : 0;
+    }
+}
+
+guint
+mce_call_latency_percentile(
+    guint percentile)
+{
+    guint sorted[MCE_CALL_LATENCY_SAMPLES];
+    const guint n = mce_call_latency_sorted(sorted);
+
+    return mce_call_latency_pick(sorted, n, percentile);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
 static
 void
 mce_proxy_init(
@@ -261,18 +1797,12 @@ mce_proxy_finalize(
     MceProxy* self = MCE_PROXY(object);
     MceProxyPriv* priv = self->priv;
 
-    if (priv->mce_watch_id) {
-        g_bus_unwatch_name(priv->mce_watch_id);
-    }
-    if (self->signal) {
-        g_object_unref(self->signal);
-    }
-    if (self->request) {
-        g_object_unref(self->request);
-    }
-    if (priv->bus) {
-        g_object_unref(priv->bus);
+    if (priv->reconnect_id) {
+        g_source_remove(priv->reconnect_id);
     }
+    /* Nobody is listening anymore */
+    mce_proxy_drop_bus(self, FALSE);
+    g_slist_free_full(priv->subs, mce_signal_sub_drop);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -288,6 +1818,10 @@ mce_proxy_class_init(
         g_signal_new(SIGNAL_VALID_CHANGED_NAME,
             G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
             0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_proxy_signals[SIGNAL_NOKIA_VALID_CHANGED] =
+        g_signal_new(SIGNAL_NOKIA_VALID_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
 }
 
 /*
@@ -39,22 +39,75 @@
 
 #include "mce_types.h"
 
+#include <gio/gio.h>
+
+#define MCE_SERVICE "com.canonical.Unity.Screen"
+#define MCE_INTERFACE "com.canonical.Unity.Screen"
+#define MCE_REQUEST_PATH "/com/canonical/Unity/Screen"
+#define MCE_SIGNAL_PATH "/com/canonical/Unity/Screen"
+
+/* The mce daemon itself, for things which Unity.Screen doesn't provide */
+#define NOKIA_MCE_SERVICE "com.nokia.mce"
+#define NOKIA_MCE_REQUEST_INTERFACE "com.nokia.mce.request"
+#define NOKIA_MCE_REQUEST_PATH "/com/nokia/mce/request"
+#define NOKIA_MCE_SIGNAL_INTERFACE "com.nokia.mce.signal"
+#define NOKIA_MCE_SIGNAL_PATH "/com/nokia/mce/signal"
+
 typedef struct mce_proxy_priv MceProxyPriv;
+typedef struct mce_proxy MceProxy;
 struct _ComCanonicalUnityScreen;
+struct _ComNokiaMceRequest;
+struct _ComNokiaMceSignal;
+
+/*
+ * The service providing display (and possibly tklock) state. The
+ * backend is detected once, when the library first connects to the
+ * bus. Signal arguments and query replies are parsed by the backend.
+ * Backends without tklock support have NULL tklock members.
+ */
+typedef struct mce_proxy_backend {
+    const char* name;
+    const char* service;
+    const char* signal_interface;
+    const char* signal_path;
+    gboolean (*ready)(MceProxy* proxy);
+    gpointer (*request)(MceProxy* proxy);
+    const char* display_signal;
+    const char* display_signature;
+    const char* display_query;
+    const char* display_reply;
+    int (*display_state)(GVariant* args);
+    const char* tklock_signal;
+    const char* tklock_signature;
+    const char* tklock_query;
+    const char* tklock_reply;
+    int (*tklock_mode)(GVariant* args);
+} MceBackend;
 
-typedef struct mce_proxy {
+struct mce_proxy {
     GObject object;
     MceProxyPriv* priv;
-    gboolean valid;
+    const MceBackend* backend; /* NULL until connected to the bus */
+    gboolean valid; /* The backend service is there */
     struct _ComCanonicalUnityScreen* signal;
     struct _ComCanonicalUnityScreen* request;
-} MceProxy;
+    gboolean nokia_valid;
+    struct _ComNokiaMceSignal* nokia_signal;
+    struct _ComNokiaMceRequest* nokia_request;
+};
 
 typedef void
 (*MceProxyFunc)(
     MceProxy* proxy,
     void* arg);
 
+typedef void
+(*MceProxyCallFunc)(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg);
+
 MceProxy*
 mce_proxy_new(
     void);
@@ -67,17 +120,63 @@ void
 mce_proxy_unref(
     MceProxy* proxy);
 
+/*
+ * Valid handlers are also invoked (with the valid flags being FALSE)
+ * when the bus connection is lost, even if the service wasn't there.
+ * That's when the handlers must drop their signal subscriptions, the
+ * signal proxies and the connection are going away.
+ */
 gulong
 mce_proxy_add_valid_changed_handler(
     MceProxy* proxy,
     MceProxyFunc fn,
     void* arg);
 
+gulong
+mce_proxy_add_nokia_valid_changed_handler(
+    MceProxy* proxy,
+    MceProxyFunc fn,
+    void* arg);
+
 void
 mce_proxy_remove_handler(
     MceProxy* proxy,
     gulong id);
 
+/*
+ * Subscribes to a backend signal directly on the connection.
+ * Returns zero if there's no connection (yet). Subscriptions don't
+ * survive the loss of connection, they should be dropped when the
+ * proxy becomes invalid and renewed when it becomes valid again.
+ */
+guint
+mce_proxy_subscribe(
+    MceProxy* proxy,
+    const char* member,
+    GDBusSignalCallback fn,
+    void* arg);
+
+void
+mce_proxy_unsubscribe(
+    MceProxy* proxy,
+    guint id);
+
+/*
+ * Issues a method call on the target (proxy->request or
+ * proxy->nokia_request) honoring the settings from mce_call.h.
+ * The callback is always invoked exactly once, with either the
+ * result of reply_type or an error.
+ */
+void
+mce_proxy_call(
+    MceProxy* proxy,
+    gpointer target,
+    const char* method,
+    GVariant* params,
+    const GVariantType* reply_type,
+    MceProxyCallFunc fn,
+    void* arg);
+
 #endif /* MCE_PROXY_H */
 
 /*
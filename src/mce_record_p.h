@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_RECORD_PRIVATE_H
+#define MCE_RECORD_PRIVATE_H
+
+#include "mce_types.h"
+
+/*
+ * Recording file layout (all integers are little-endian):
+ *
+ *   8 bytes   MCE_RECORD_MAGIC
+ *
+ * followed by any number of records:
+ *
+ *   8 bytes   timestamp, microseconds since the start of recording
+ *   4 bytes   payload size
+ *   1 byte    record type (MCE_RECORD_TYPE)
+ *   N bytes   serialized little-endian GVariant payload
+ *
+ * Payload type depends on the record type, see the *_PAYLOAD macros.
+ * Version 1 recordings didn't say which service or interface a record
+ * belongs to, all of them were Unity.Screen.
+ */
+
+#define MCE_RECORD_MAGIC "MCEREC\0\2"
+#define MCE_RECORD_MAGIC_V1 "MCEREC\0\1"
+#define MCE_RECORD_MAGIC_SIZE (8)
+#define MCE_RECORD_HEADER_SIZE (13)
+
+typedef enum mce_record_type {
+    MCE_RECORD_NAME_APPEARED = 1,
+    MCE_RECORD_NAME_VANISHED,
+    MCE_RECORD_SIGNAL,
+    MCE_RECORD_REPLY
+} MCE_RECORD_TYPE;
+
+#define MCE_RECORD_NAME_APPEARED_PAYLOAD "(ss)"  /* Name, owner */
+#define MCE_RECORD_NAME_VANISHED_PAYLOAD "(s)"   /* Name */
+#define MCE_RECORD_SIGNAL_PAYLOAD        "(ssv)" /* Interface, signal, args */
+#define MCE_RECORD_REPLY_PAYLOAD         "(ssv)" /* Interface, method, reply */
+
+#define MCE_RECORD_V1_NAME_APPEARED_PAYLOAD "(s)"
+#define MCE_RECORD_V1_NAME_VANISHED_PAYLOAD "()"
+#define MCE_RECORD_V1_SIGNAL_PAYLOAD        "(sv)"
+#define MCE_RECORD_V1_REPLY_PAYLOAD         "(sv)"
+
+#endif /* MCE_RECORD_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
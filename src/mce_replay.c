@@ -0,0 +1,819 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_record.h"
+#include "mce_record_p.h"
+#include "mce_proxy.h"
+#include "mce_log_p.h"
+
+#include <string.h>
+
+/* Generated headers */
+#include "com.canonical.Unity.Screen.h"
+#include "com.nokia.mce.request.h"
+
+typedef struct mce_replay_event {
+    gint64 time;
+    MCE_RECORD_TYPE type;
+    GVariant* payload;
+} MceReplayEvent;
+
+typedef struct mce_replay_service {
+    const char* name;
+    const char* interface;
+    const char* path;
+} MceReplayService;
+
+typedef struct mce_replay_nokia_ind {
+    const char* signal;
+    const char* method;
+} MceReplayNokiaInd;
+
+struct mce_replay_priv {
+    GDBusConnection* bus;
+    ComCanonicalUnityScreen* skeleton;
+    gulong get_state_id;
+    GPtrArray* events;
+    MCE_REPLAY_SPEED speed;
+    gint64 start;
+    guint next;
+    guint event_id;
+    GHashTable* own_ids;
+    GHashTable* acquiring;
+    GHashTable* nokia_replies;
+    guint nokia_object_id;
+    gboolean exported;
+    gboolean have_state;
+    gint display_state;
+};
+
+enum mce_replay_signal {
+    SIGNAL_ACTIVE_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_ACTIVE_CHANGED_NAME  "mce-replay-active-changed"
+
+#define MCE_DISPLAY_SIG "DisplayPowerStateChange"
+#define MCE_DISPLAY_GET_STATE "getDisplayPowerState"
+
+static guint mce_replay_signals[SIGNAL_COUNT] = { 0 };
+
+/* Where the signals of each recorded interface are emitted */
+static const MceReplayService mce_replay_services[] = {
+    { MCE_SERVICE, MCE_INTERFACE, MCE_SIGNAL_PATH },
+    { NOKIA_MCE_SERVICE, NOKIA_MCE_SIGNAL_INTERFACE, NOKIA_MCE_SIGNAL_PATH },
+    { NOKIA_MCE_SERVICE, NOKIA_MCE_REQUEST_INTERFACE, NOKIA_MCE_REQUEST_PATH }
+};
+
+/* Native MCE signals carrying the same thing as the query results */
+static const MceReplayNokiaInd mce_replay_nokia_inds[] = {
+    { "battery_level_ind", "get_battery_level" },
+    { "battery_status_ind", "get_battery_status" },
+    { "charger_state_ind", "get_charger_state" },
+    { "sig_call_state_ind", "get_call_state" },
+    { "system_inactivity_ind", "get_inactivity_status" },
+    { "display_status_ind", "get_display_status" },
+    { "tklock_mode_ind", "get_tklock_mode" }
+};
+
+typedef GObjectClass MceReplayClass;
+G_DEFINE_TYPE(MceReplay, mce_replay, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_replay_parent_class
+#define MCE_REPLAY_TYPE (mce_replay_get_type())
+#define MCE_REPLAY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_REPLAY_TYPE,MceReplay))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_replay_event_free(
+    gpointer data)
+{
+    MceReplayEvent* event = data;
+
+    g_variant_unref(event->payload);
+    g_slice_free(MceReplayEvent, event);
+}
+
+static
+const GVariantType*
+mce_replay_payload_type(
+    MCE_RECORD_TYPE type)
+{
+    switch (type) {
+    case MCE_RECORD_NAME_APPEARED:
+        return G_VARIANT_TYPE(MCE_RECORD_NAME_APPEARED_PAYLOAD);
+    case MCE_RECORD_NAME_VANISHED:
+        return G_VARIANT_TYPE(MCE_RECORD_NAME_VANISHED_PAYLOAD);
+    case MCE_RECORD_SIGNAL:
+        return G_VARIANT_TYPE(MCE_RECORD_SIGNAL_PAYLOAD);
+    case MCE_RECORD_REPLY:
+        return G_VARIANT_TYPE(MCE_RECORD_REPLY_PAYLOAD);
+    }
+    /* Record types added in the future are ignored */
+    return NULL;
+}
+
+static
+const MceReplayService*
+mce_replay_service(
+    const char* interface)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(mce_replay_services); i++) {
+        if (!g_strcmp0(mce_replay_services[i].interface, interface)) {
+            return mce_replay_services + i;
+        }
+    }
+    return NULL;
+}
+
+static
+const GVariantType*
+mce_replay_payload_type_v1(
+    MCE_RECORD_TYPE type)
+{
+    switch (type) {
+    case MCE_RECORD_NAME_APPEARED:
+        return G_VARIANT_TYPE(MCE_RECORD_V1_NAME_APPEARED_PAYLOAD);
+    case MCE_RECORD_NAME_VANISHED:
+        return G_VARIANT_TYPE(MCE_RECORD_V1_NAME_VANISHED_PAYLOAD);
+    case MCE_RECORD_SIGNAL:
+        return G_VARIANT_TYPE(MCE_RECORD_V1_SIGNAL_PAYLOAD);
+    case MCE_RECORD_REPLY:
+        return G_VARIANT_TYPE(MCE_RECORD_V1_REPLY_PAYLOAD);
+    }
+    return NULL;
+}
+
+static
+GVariant*
+mce_replay_upgrade_v1(
+    MCE_RECORD_TYPE type,
+    GVariant* payload)
+{
+    /* Everything in a version 1 recording came from Unity.Screen */
+    GVariant* upgraded = NULL;
+    const char* name = NULL;
+    GVariant* value = NULL;
+
+    switch (type) {
+    case MCE_RECORD_NAME_APPEARED:
+        g_variant_get(payload, "(&s)", &name);
+        upgraded = g_variant_new(MCE_RECORD_NAME_APPEARED_PAYLOAD,
+            MCE_SERVICE, name);
+        break;
+    case MCE_RECORD_NAME_VANISHED:
+        upgraded = g_variant_new(MCE_RECORD_NAME_VANISHED_PAYLOAD,
+            MCE_SERVICE);
+        break;
+    case MCE_RECORD_SIGNAL:
+    case MCE_RECORD_REPLY:
+        g_variant_get(payload, "(&sv)", &name, &value);
+        upgraded = g_variant_new(MCE_RECORD_SIGNAL_PAYLOAD,
+            MCE_INTERFACE, name, value);
+        g_variant_unref(value);
+        break;
+    }
+    g_variant_unref(payload);
+    return g_variant_ref_sink(upgraded);
+}
+
+static
+GPtrArray*
+mce_replay_parse(
+    const guint8* data,
+    gsize size,
+    GError** error)
+{
+    const guint8* ptr = data + MCE_RECORD_MAGIC_SIZE;
+    const guint8* end = data + size;
+    gboolean v1 = FALSE;
+    GPtrArray* events;
+
+    if (size >= MCE_RECORD_MAGIC_SIZE &&
+        !memcmp(data, MCE_RECORD_MAGIC_V1, MCE_RECORD_MAGIC_SIZE)) {
+        v1 = TRUE;
+    } else if (size < MCE_RECORD_MAGIC_SIZE ||
+        memcmp(data, MCE_RECORD_MAGIC, MCE_RECORD_MAGIC_SIZE)) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+            "Not an MCE recording");
+        return NULL;
+    }
+
+    events = g_ptr_array_new_with_free_func(mce_replay_event_free);
+    while (ptr < end) {
+        const GVariantType* type;
+        MCE_RECORD_TYPE record_type;
+        guint64 time;
+        guint32 len;
+
+        if ((gsize)(end - ptr) < MCE_RECORD_HEADER_SIZE) {
+            break;
+        }
+        memcpy(&time, ptr, 8);
+        memcpy(&len, ptr + 8, 4);
+        len = GUINT32_FROM_LE(len);
+        record_type = ptr[12];
+        type = v1 ? mce_replay_payload_type_v1(record_type) :
+            mce_replay_payload_type(record_type);
+        ptr += MCE_RECORD_HEADER_SIZE;
+        if ((gsize)(end - ptr) < len) {
+            break;
+        }
+        if (type) {
+            MceReplayEvent* event = g_slice_new(MceReplayEvent);
+            GBytes* bytes = g_bytes_new(ptr, len);
+            GVariant* payload = g_variant_ref_sink
+                (g_variant_new_from_bytes(type, bytes, FALSE));
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+            GVariant* swapped = g_variant_byteswap(payload);
+
+            g_variant_unref(payload);
+            payload = swapped;
+#endif
+            g_bytes_unref(bytes);
+            if (v1) {
+                payload = mce_replay_upgrade_v1(record_type, payload);
+            }
+            event->time = GUINT64_FROM_LE(time);
+            event->type = record_type;
+            event->payload = payload;
+            g_ptr_array_add(events, event);
+        }
+        ptr += len;
+    }
+
+    if (ptr < end) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+            "Truncated MCE recording");
+        g_ptr_array_free(events, TRUE);
+        return NULL;
+    }
+    return events;
+}
+
+static
+gboolean
+mce_replay_next(
+    gpointer arg);
+
+static
+void
+mce_replay_name_settled(
+    MceReplay* self,
+    const char* name)
+{
+    MceReplayPriv* priv = self->priv;
+
+    /* Resume the replay once all pending names have been settled */
+    if (g_hash_table_remove(priv->acquiring, name) &&
+        !g_hash_table_size(priv->acquiring) &&
+        self->active && !priv->event_id) {
+        priv->event_id = g_idle_add(mce_replay_next, self);
+    }
+}
+
+static
+void
+mce_replay_name_acquired(
+    GDBusConnection* bus,
+    const gchar* name,
+    gpointer arg)
+{
+    GDEBUG("Acquired '%s'", name);
+    mce_replay_name_settled(MCE_REPLAY(arg), name);
+}
+
+static
+void
+mce_replay_name_lost(
+    GDBusConnection* bus,
+    const gchar* name,
+    gpointer arg)
+{
+    GWARN("Failed to acquire '%s'", name);
+    mce_replay_name_settled(MCE_REPLAY(arg), name);
+}
+
+static
+void
+mce_replay_own_name(
+    MceReplay* self,
+    const char* name)
+{
+    MceReplayPriv* priv = self->priv;
+
+    if (!g_hash_table_contains(priv->own_ids, name)) {
+        g_hash_table_add(priv->acquiring, g_strdup(name));
+        g_hash_table_insert(priv->own_ids, g_strdup(name), GUINT_TO_POINTER
+            (g_bus_own_name_on_connection(priv->bus, name,
+            G_BUS_NAME_OWNER_FLAGS_REPLACE, mce_replay_name_acquired,
+            mce_replay_name_lost, self, NULL)));
+    }
+}
+
+static
+void
+mce_replay_unown_name(
+    MceReplayPriv* priv,
+    const char* name)
+{
+    gpointer id;
+
+    if (g_hash_table_lookup_extended(priv->own_ids, name, NULL, &id)) {
+        g_bus_unown_name(GPOINTER_TO_UINT(id));
+        g_hash_table_remove(priv->own_ids, name);
+        g_hash_table_remove(priv->acquiring, name);
+    }
+}
+
+static
+void
+mce_replay_unown_all(
+    MceReplayPriv* priv)
+{
+    GHashTableIter it;
+    gpointer id;
+
+    g_hash_table_iter_init(&it, priv->own_ids);
+    while (g_hash_table_iter_next(&it, NULL, &id)) {
+        g_bus_unown_name(GPOINTER_TO_UINT(id));
+        g_hash_table_iter_remove(&it);
+    }
+    g_hash_table_remove_all(priv->acquiring);
+}
+
+static
+void
+mce_replay_set_active(
+    MceReplay* self,
+    gboolean active)
+{
+    if (self->active != active) {
+        self->active = active;
+        g_signal_emit(self, mce_replay_signals[SIGNAL_ACTIVE_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_replay_signal(
+    MceReplay* self,
+    GVariant* payload)
+{
+    MceReplayPriv* priv = self->priv;
+    GError* error = NULL;
+    const char* iface = NULL;
+    const char* name = NULL;
+    GVariant* args = NULL;
+    const MceReplayService* service;
+
+    g_variant_get(payload, "(&s&sv)", &iface, &name, &args);
+    service = mce_replay_service(iface);
+    if (service && g_variant_is_of_type(args, G_VARIANT_TYPE_TUPLE)) {
+        if (!g_strcmp0(iface, MCE_INTERFACE) &&
+            !g_strcmp0(name, MCE_DISPLAY_SIG) &&
+            g_variant_is_of_type(args, G_VARIANT_TYPE("(ii)"))) {
+            g_variant_get(args, "(ii)", &priv->display_state, NULL);
+        } else if (!g_strcmp0(iface, NOKIA_MCE_SIGNAL_INTERFACE)) {
+            guint i;
+
+            /* Subsequent queries return what has just been announced */
+            for (i = 0; i < G_N_ELEMENTS(mce_replay_nokia_inds); i++) {
+                const MceReplayNokiaInd* ind = mce_replay_nokia_inds + i;
+
+                if (!strcmp(ind->signal, name)) {
+                    g_hash_table_insert(priv->nokia_replies,
+                        g_strdup(ind->method), g_variant_ref(args));
+                    break;
+                }
+            }
+        }
+        if (!g_dbus_connection_emit_signal(priv->bus, NULL, service->path,
+            iface, name, args, &error)) {
+            GWARN("Failed to emit %s: %s", name, GERRMSG(error));
+            g_error_free(error);
+        }
+    }
+    g_variant_unref(args);
+}
+
+static
+void
+mce_replay_reply(
+    MceReplay* self,
+    GVariant* payload,
+    gboolean initial)
+{
+    MceReplayPriv* priv = self->priv;
+    const char* iface = NULL;
+    const char* name = NULL;
+    GVariant* result = NULL;
+
+    /* The initial state comes from the first recorded reply */
+    g_variant_get(payload, "(&s&sv)", &iface, &name, &result);
+    if (!g_strcmp0(iface, MCE_INTERFACE)) {
+        if (!g_strcmp0(name, MCE_DISPLAY_GET_STATE) &&
+            g_variant_is_of_type(result, G_VARIANT_TYPE("(i)")) &&
+            !(initial && priv->have_state)) {
+            g_variant_get(result, "(i)", &priv->display_state);
+            priv->have_state = TRUE;
+        }
+    } else if (!g_strcmp0(iface, NOKIA_MCE_REQUEST_INTERFACE)) {
+        if (g_variant_is_of_type(result, G_VARIANT_TYPE_TUPLE) &&
+            !(initial && g_hash_table_contains(priv->nokia_replies, name))) {
+            g_hash_table_insert(priv->nokia_replies, g_strdup(name),
+                g_variant_ref(result));
+        }
+    }
+    g_variant_unref(result);
+}
+
+static
+void
+mce_replay_dispatch(
+    MceReplay* self,
+    MceReplayEvent* event)
+{
+    MceReplayPriv* priv = self->priv;
+    const char* name = NULL;
+
+    switch (event->type) {
+    case MCE_RECORD_NAME_APPEARED:
+        g_variant_get(event->payload, "(&s&s)", &name, NULL);
+        mce_replay_own_name(self, name);
+        break;
+    case MCE_RECORD_NAME_VANISHED:
+        g_variant_get(event->payload, "(&s)", &name);
+        mce_replay_unown_name(priv, name);
+        break;
+    case MCE_RECORD_SIGNAL:
+        mce_replay_signal(self, event->payload);
+        break;
+    case MCE_RECORD_REPLY:
+        mce_replay_reply(self, event->payload, FALSE);
+        break;
+    }
+}
+
+static
+gboolean
+mce_replay_next(
+    gpointer arg)
+{
+    MceReplay* self = MCE_REPLAY(arg);
+    MceReplayPriv* priv = self->priv;
+    GPtrArray* events = priv->events;
+
+    priv->event_id = 0;
+    while (priv->next < events->len) {
+        MceReplayEvent* event = g_ptr_array_index(events, priv->next);
+
+        /*
+         * Nothing goes out before the names are actually owned, or
+         * the clients would miss the signals (especially at the fast
+         * speed when the whole replay fits into a single idle callback)
+         */
+        if (g_hash_table_size(priv->acquiring)) {
+            return G_SOURCE_REMOVE;
+        }
+        if (priv->speed == MCE_REPLAY_SPEED_RECORDED) {
+            const gint64 due = priv->start + event->time;
+            const gint64 now = g_get_monotonic_time();
+
+            if (due > now) {
+                priv->event_id = g_timeout_add((due - now + 999) / 1000,
+                    mce_replay_next, self);
+                return G_SOURCE_REMOVE;
+            }
+        }
+        priv->next++;
+        mce_replay_dispatch(self, event);
+    }
+
+    /* The names (if owned) stay around until the replay is stopped */
+    GDEBUG("Replay finished");
+    mce_replay_set_active(self, FALSE);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+mce_replay_handle_get_state(
+    ComCanonicalUnityScreen* skeleton,
+    GDBusMethodInvocation* call,
+    gpointer arg)
+{
+    MceReplay* self = MCE_REPLAY(arg);
+
+    com_canonical_unity_screen_complete_get_display_power_state(skeleton,
+        call, self->priv->display_state);
+    return TRUE;
+}
+
+static
+void
+mce_replay_nokia_call(
+    GDBusConnection* bus,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* method,
+    GVariant* args,
+    GDBusMethodInvocation* call,
+    gpointer arg)
+{
+    MceReplay* self = MCE_REPLAY(arg);
+    GVariant* result = g_hash_table_lookup(self->priv->nokia_replies,
+        method);
+
+    if (result) {
+        g_dbus_method_invocation_return_value(call, result);
+    } else {
+        g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+            G_DBUS_ERROR_FAILED, "Nothing recorded for %s", method);
+    }
+}
+
+static const GDBusInterfaceVTable mce_replay_nokia_vtable = {
+    mce_replay_nokia_call
+};
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceReplay*
+mce_replay_new(
+    GDBusConnection* bus,
+    const char* path,
+    GError** error)
+{
+    gchar* data = NULL;
+    gsize size = 0;
+
+    if (g_file_get_contents(path, &data, &size, error)) {
+        GPtrArray* events = mce_replay_parse((guint8*)data, size, error);
+
+        g_free(data);
+        if (events) {
+            MceReplay* self = g_object_new(MCE_REPLAY_TYPE, NULL);
+            MceReplayPriv* priv = self->priv;
+
+            priv->bus = g_object_ref(bus);
+            priv->events = events;
+            if (g_dbus_interface_skeleton_export
+                (G_DBUS_INTERFACE_SKELETON(priv->skeleton), bus,
+                MCE_REQUEST_PATH, error)) {
+                priv->exported = TRUE;
+                priv->nokia_object_id = g_dbus_connection_register_object
+                    (bus, NOKIA_MCE_REQUEST_PATH,
+                    com_nokia_mce_request_interface_info(),
+                    &mce_replay_nokia_vtable, self, NULL, error);
+                if (priv->nokia_object_id) {
+                    GDEBUG("Loaded %u events from %s", events->len, path);
+                    return self;
+                }
+            }
+            mce_replay_unref(self);
+        }
+    }
+    return NULL;
+}
+
+MceReplay*
+mce_replay_ref(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_REPLAY(self));
+    }
+    return self;
+}
+
+void
+mce_replay_unref(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_unref(MCE_REPLAY(self));
+    }
+}
+
+gboolean
+mce_replay_start(
+    MceReplay* self,
+    MCE_REPLAY_SPEED speed)
+{
+    if (G_LIKELY(self) && !self->active) {
+        MceReplayPriv* priv = self->priv;
+        GPtrArray* events = priv->events;
+        GHashTable* seen = g_hash_table_new(g_str_hash, g_str_equal);
+        guint i;
+
+        /*
+         * If the recording was started when MCE was already running,
+         * the names it was talking to have to appear right away, i.e.
+         * every name which is used before being seen appearing. The
+         * initial state is taken from the first recorded replies.
+         */
+        priv->have_state = FALSE;
+        g_hash_table_remove_all(priv->nokia_replies);
+        for (i = 0; i < events->len; i++) {
+            MceReplayEvent* event = g_ptr_array_index(events, i);
+            const MceReplayService* service;
+            const char* name = NULL;
+
+            switch (event->type) {
+            case MCE_RECORD_NAME_APPEARED:
+                g_variant_get(event->payload, "(&s&s)", &name, NULL);
+                g_hash_table_add(seen, (gpointer)name);
+                break;
+            case MCE_RECORD_NAME_VANISHED:
+                g_variant_get(event->payload, "(&s)", &name);
+                if (g_hash_table_add(seen, (gpointer)name)) {
+                    mce_replay_own_name(self, name);
+                }
+                break;
+            case MCE_RECORD_REPLY:
+                mce_replay_reply(self, event->payload, TRUE);
+                /* fallthrough */
+            case MCE_RECORD_SIGNAL:
+                g_variant_get(event->payload, "(&s&sv)", &name, NULL, NULL);
+                service = mce_replay_service(name);
+                if (service && g_hash_table_add(seen,
+                    (gpointer)service->name)) {
+                    mce_replay_own_name(self, service->name);
+                }
+                break;
+            }
+        }
+        g_hash_table_destroy(seen);
+
+        priv->speed = speed;
+        priv->next = 0;
+        priv->start = g_get_monotonic_time();
+        priv->event_id = g_idle_add(mce_replay_next, self);
+        mce_replay_set_active(self, TRUE);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+void
+mce_replay_stop(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        MceReplayPriv* priv = self->priv;
+
+        if (priv->event_id) {
+            g_source_remove(priv->event_id);
+            priv->event_id = 0;
+        }
+        mce_replay_unown_all(priv);
+        mce_replay_set_active(self, FALSE);
+    }
+}
+
+gulong
+mce_replay_add_active_changed_handler(
+    MceReplay* self,
+    MceReplayFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
+        SIGNAL_ACTIVE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+void
+mce_replay_remove_handler(
+    MceReplay* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        g_signal_handler_disconnect(self, id);
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_replay_init(
+    MceReplay* self)
+{
+    MceReplayPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_REPLAY_TYPE,
+        MceReplayPriv);
+
+    self->priv = priv;
+    priv->own_ids = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, NULL);
+    priv->acquiring = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, NULL);
+    priv->nokia_replies = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify)g_variant_unref);
+    priv->skeleton = com_canonical_unity_screen_skeleton_new();
+    priv->get_state_id = g_signal_connect(priv->skeleton,
+        "handle-get-display-power-state",
+        G_CALLBACK(mce_replay_handle_get_state), self);
+}
+
+static
+void
+mce_replay_finalize(
+    GObject* object)
+{
+    MceReplay* self = MCE_REPLAY(object);
+    MceReplayPriv* priv = self->priv;
+
+    if (priv->event_id) {
+        g_source_remove(priv->event_id);
+    }
+    mce_replay_unown_all(priv);
+    g_hash_table_destroy(priv->own_ids);
+    g_hash_table_destroy(priv->acquiring);
+    g_signal_handler_disconnect(priv->skeleton, priv->get_state_id);
+    if (priv->exported) {
+        g_dbus_interface_skeleton_unexport
+            (G_DBUS_INTERFACE_SKELETON(priv->skeleton));
+    }
+    if (priv->nokia_object_id) {
+        g_dbus_connection_unregister_object(priv->bus,
+            priv->nokia_object_id);
+    }
+    g_hash_table_destroy(priv->nokia_replies);
+    g_object_unref(priv->skeleton);
+    if (priv->events) {
+        g_ptr_array_free(priv->events, TRUE);
+    }
+    if (priv->bus) {
+        g_object_unref(priv->bus);
+    }
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_replay_class_init(
+    MceReplayClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_replay_finalize;
+    g_type_class_add_private(klass, sizeof(MceReplayPriv));
+    mce_replay_signals[SIGNAL_ACTIVE_CHANGED] =
+        g_signal_new(SIGNAL_ACTIVE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,713 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#define _GNU_SOURCE /* memfd_create, accept4 */
+
+#include "mce_shm_p.h"
+#include "mce_display.h"
+#include "mce_tklock.h"
+#include "mce_log_p.h"
+
+#include <gio/gio.h>
+#include <glib-unix.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+
+/* Abstract socket the readers receive the page and eventfd from */
+#define MCE_SHM_SOCKET "mce-glib-state"
+
+#define MCE_SHM_MAGIC (0x5345434d) /* "MCES" */
+#define MCE_SHM_VERSION (1)
+#define MCE_SHM_PAGE_SIZE (4096)
+
+/* Room for more descriptors than expected, to see what we have got */
+#define MCE_SHM_MAX_FDS (4)
+
+/*
+ * A reader gives up after this many attempts to get a consistent
+ * snapshot, the publisher has probably died in the middle of update.
+ */
+#define MCE_SHM_READ_RETRIES (1000)
+
+/*
+ * The page is protected by a seqlock. The sequence number is odd
+ * while the publisher is updating the page.
+ */
+typedef struct mce_shm_page {
+    guint32 magic;
+    guint32 version;
+    gint seq;
+    gint display_valid;
+    gint display_state;
+    gint tklock_valid;
+    gint tklock_mode;
+    gint tklock_locked;
+} MceShmPage;
+
+struct mce_shm {
+    int sock;
+    guint sock_id;
+    int efd;
+    guint efd_id;
+    const MceShmPage* page;
+    MceShmFunc changed;
+    MceShmFunc lost;
+    void* arg;
+};
+
+typedef struct mce_shm_publisher MceShmPublisher;
+
+typedef struct mce_shm_client {
+    MceShmPublisher* pub;
+    int sock;
+    guint sock_id;
+    int efd;
+} MceShmClient;
+
+enum mce_shm_display_events {
+    DISPLAY_EVENT_VALID,
+    DISPLAY_EVENT_STATE,
+    DISPLAY_EVENT_COUNT
+};
+
+enum mce_shm_tklock_events {
+    TKLOCK_EVENT_VALID,
+    TKLOCK_EVENT_MODE,
+    TKLOCK_EVENT_LOCKED,
+    TKLOCK_EVENT_COUNT
+};
+
+struct mce_shm_publisher {
+    int memfd;
+    int rofd;
+    MceShmPage* page;
+    int sock;
+    guint sock_id;
+    GSList* clients;
+    MceDisplay* display;
+    gulong display_event_id[DISPLAY_EVENT_COUNT];
+    MceTklock* tklock;
+    gulong tklock_event_id[TKLOCK_EVENT_COUNT];
+};
+
+static gboolean mce_shm_reader_enabled = FALSE;
+static MceShmPublisher* mce_shm_publisher = NULL;
+
+static
+socklen_t
+mce_shm_address(
+    struct sockaddr_un* sa)
+{
+    const gsize len = strlen(MCE_SHM_SOCKET);
+
+    /* Abstract namespace, sun_path starts with a zero byte */
+    memset(sa, 0, sizeof(*sa));
+    sa->sun_family = AF_UNIX;
+    memcpy(sa->sun_path + 1, MCE_SHM_SOCKET, len);
+    return offsetof(struct sockaddr_un, sun_path) + 1 + len;
+}
+
+/*==========================================================================*
+ * Reader
+ *==========================================================================*/
+
+static
+gboolean
+mce_shm_notify(
+    gint fd,
+    GIOCondition condition,
+    gpointer arg)
+{
+    MceShm* shm = arg;
+    guint64 count;
+
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        GWARN("Failed to read eventfd: %s", strerror(errno));
+    }
+    shm->changed(shm, shm->arg);
+    return G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+mce_shm_map(
+    MceShm* shm,
+    int page_fd,
+    int efd)
+{
+    const MceShmPage* page = MAP_FAILED;
+    struct stat st;
+
+    /*
+     * A page which can shrink under our feet would get us SIGBUS
+     * on access, only take a sealed one of full size.
+     */
+    if ((fcntl(page_fd, F_GET_SEALS) & F_SEAL_SHRINK) &&
+        fstat(page_fd, &st) == 0 && st.st_size >= MCE_SHM_PAGE_SIZE) {
+        page = mmap(NULL, MCE_SHM_PAGE_SIZE, PROT_READ, MAP_SHARED,
+            page_fd, 0);
+    } else {
+        GWARN("MCE state page is not sealed");
+    }
+    close(page_fd);
+    if (page != MAP_FAILED) {
+        if (page->magic == MCE_SHM_MAGIC &&
+            page->version == MCE_SHM_VERSION) {
+            GDEBUG("Attached to MCE state page");
+            shm->page = page;
+            shm->efd = efd;
+            shm->efd_id = g_unix_fd_add(shm->efd, G_IO_IN,
+                mce_shm_notify, shm);
+            return TRUE;
+        }
+        GWARN("Unsupported MCE state page");
+        munmap((void*)page, MCE_SHM_PAGE_SIZE);
+    }
+    close(efd);
+    return FALSE;
+}
+
+static
+gboolean
+mce_shm_receive(
+    MceShm* shm)
+{
+    char byte;
+    struct iovec iov;
+    struct msghdr msg;
+    int fds[MCE_SHM_MAX_FDS];
+    guint i, n = 0;
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(MCE_SHM_MAX_FDS * sizeof(int))];
+    } control;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    if (recvmsg(shm->sock, &msg, MSG_CMSG_CLOEXEC) == 1) {
+        struct cmsghdr* cmsg;
+
+        /*
+         * Whatever shape the control data has, the kernel has already
+         * installed every descriptor which fit into the buffer. Collect
+         * them all, so that the ones we don't take get closed.
+         */
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET &&
+                cmsg->cmsg_type == SCM_RIGHTS) {
+                const guchar* data = CMSG_DATA(cmsg);
+                const guint count = (cmsg->cmsg_len - CMSG_LEN(0)) /
+                    sizeof(int);
+
+                for (i = 0; i < count && n < MCE_SHM_MAX_FDS; i++) {
+                    memcpy(fds + (n++), data + i * sizeof(int),
+                        sizeof(int));
+                }
+            }
+        }
+
+        /* Expecting exactly the page and the eventfd */
+        if (n == 2 && !(msg.msg_flags & MSG_CTRUNC)) {
+            return mce_shm_map(shm, fds[0], fds[1]);
+        }
+        GWARN("Unexpected message from MCE state publisher");
+        for (i = 0; i < n; i++) {
+            close(fds[i]);
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+mce_shm_socket_event(
+    gint fd,
+    GIOCondition condition,
+    gpointer arg)
+{
+    MceShm* shm = arg;
+
+    if (!(condition & (G_IO_HUP | G_IO_ERR)) && !shm->page &&
+        mce_shm_receive(shm)) {
+        shm->changed(shm, shm->arg);
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* The publisher has gone (or misbehaved) */
+    GDEBUG("Lost MCE state publisher");
+    shm->sock_id = 0;
+    shm->lost(shm, shm->arg);
+    return G_SOURCE_REMOVE;
+}
+
+MceShm*
+mce_shm_attach(
+    MceShmFunc changed,
+    MceShmFunc lost,
+    void* arg)
+{
+    /* The publisher itself has to talk to MCE */
+    if (mce_shm_reader_enabled && !mce_shm_publisher) {
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd >= 0) {
+            struct sockaddr_un sa;
+            const socklen_t len = mce_shm_address(&sa);
+
+            if (connect(fd, (struct sockaddr*)&sa, len) == 0) {
+                struct ucred cred;
+                socklen_t credlen = sizeof(cred);
+                MceShm* shm;
+
+                /*
+                 * Anyone can bind an abstract socket. Only trust the
+                 * publisher running as root or as ourselves.
+                 */
+                if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred,
+                    &credlen) < 0 || (cred.uid && cred.uid != geteuid())) {
+                    GWARN("Ignoring untrusted MCE state publisher");
+                    close(fd);
+                    return NULL;
+                }
+
+                shm = g_slice_new0(MceShm);
+                shm->sock = fd;
+                shm->efd = -1;
+                shm->changed = changed;
+                shm->lost = lost;
+                shm->arg = arg;
+                shm->sock_id = g_unix_fd_add(fd, G_IO_IN | G_IO_HUP |
+                    G_IO_ERR, mce_shm_socket_event, shm);
+                return shm;
+            }
+            GDEBUG("No MCE state publisher");
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+void
+mce_shm_detach(
+    MceShm* shm)
+{
+    if (shm) {
+        if (shm->efd_id) {
+            g_source_remove(shm->efd_id);
+        }
+        if (shm->efd >= 0) {
+            close(shm->efd);
+        }
+        if (shm->page) {
+            munmap((void*)shm->page, MCE_SHM_PAGE_SIZE);
+        }
+        if (shm->sock_id) {
+            g_source_remove(shm->sock_id);
+        }
+        close(shm->sock);
+        g_slice_free(MceShm, shm);
+    }
+}
+
+gboolean
+mce_shm_read(
+    MceShm* shm,
+    MceShmState* state)
+{
+    const MceShmPage* page = shm ? shm->page : NULL;
+
+    if (page) {
+        guint i;
+
+        for (i = 0; i < MCE_SHM_READ_RETRIES; i++) {
+            const gint seq = g_atomic_int_get(&page->seq);
+
+            if (!(seq & 1)) {
+                state->display_valid = page->display_valid;
+                state->display_state = page->display_state;
+                state->tklock_valid = page->tklock_valid;
+                state->tklock_mode = page->tklock_mode;
+                state->tklock_locked = page->tklock_locked;
+                __sync_synchronize();
+                if (g_atomic_int_get(&page->seq) == seq) {
+                    return TRUE;
+                }
+            } else {
+                g_thread_yield();
+            }
+        }
+        GWARN("MCE state page is stuck in update");
+    }
+    return FALSE;
+}
+
+/*==========================================================================*
+ * Publisher
+ *==========================================================================*/
+
+static
+void
+mce_shm_client_free(
+    MceShmClient* client)
+{
+    if (client->sock_id) {
+        g_source_remove(client->sock_id);
+    }
+    close(client->efd);
+    close(client->sock);
+    g_slice_free(MceShmClient, client);
+}
+
+static
+void
+mce_shm_client_free1(
+    gpointer client)
+{
+    mce_shm_client_free(client);
+}
+
+static
+gboolean
+mce_shm_client_event(
+    gint fd,
+    GIOCondition condition,
+    gpointer arg)
+{
+    MceShmClient* client = arg;
+    MceShmPublisher* pub = client->pub;
+
+    /* Readers never send anything, this must be a disconnect */
+    pub->clients = g_slist_remove(pub->clients, client);
+    client->sock_id = 0;
+    mce_shm_client_free(client);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+mce_shm_client_send(
+    int sock,
+    int page_fd,
+    int efd)
+{
+    char byte = 0;
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr* cmsg;
+    int fds[2];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    fds[0] = page_fd;
+    fds[1] = efd;
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == 1;
+}
+
+static
+gboolean
+mce_shm_publisher_accept(
+    gint fd,
+    GIOCondition condition,
+    gpointer arg)
+{
+    MceShmPublisher* pub = arg;
+    const int sock = accept4(fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+
+    if (sock >= 0) {
+        const int efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        if (efd >= 0 && mce_shm_client_send(sock, pub->rofd, efd)) {
+            MceShmClient* client = g_slice_new0(MceShmClient);
+
+            client->pub = pub;
+            client->sock = sock;
+            client->efd = efd;
+            client->sock_id = g_unix_fd_add(sock, G_IO_IN | G_IO_HUP |
+                G_IO_ERR, mce_shm_client_event, client);
+            pub->clients = g_slist_prepend(pub->clients, client);
+            GDEBUG("MCE state reader connected");
+        } else {
+            GWARN("Failed to set up MCE state reader: %s", strerror(errno));
+            if (efd >= 0) {
+                close(efd);
+            }
+            close(sock);
+        }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static
+void
+mce_shm_publisher_update(
+    MceShmPublisher* pub)
+{
+    MceShmPage* page = pub->page;
+    const MceDisplay* display = pub->display;
+    const MceTklock* tklock = pub->tklock;
+    const guint64 one = 1;
+    GSList* l;
+
+    g_atomic_int_inc(&page->seq);
+    __sync_synchronize();
+    page->display_valid = display->valid;
+    page->display_state = display->state;
+    page->tklock_valid = tklock->valid;
+    page->tklock_mode = tklock->mode;
+    page->tklock_locked = tklock->locked;
+    __sync_synchronize();
+    g_atomic_int_inc(&page->seq);
+
+    for (l = pub->clients; l; l = l->next) {
+        MceShmClient* client = l->data;
+
+        if (write(client->efd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            GWARN("Failed to notify MCE state reader: %s", strerror(errno));
+        }
+    }
+}
+
+static
+void
+mce_shm_publisher_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    mce_shm_publisher_update(arg);
+}
+
+static
+void
+mce_shm_publisher_tklock_changed(
+    MceTklock* tklock,
+    void* arg)
+{
+    mce_shm_publisher_update(arg);
+}
+
+static
+void
+mce_shm_publisher_free(
+    MceShmPublisher* pub)
+{
+    if (pub->display) {
+        mce_display_remove_all_handlers(pub->display, pub->display_event_id);
+        mce_display_unref(pub->display);
+    }
+    if (pub->tklock) {
+        mce_tklock_remove_all_handlers(pub->tklock, pub->tklock_event_id);
+        mce_tklock_unref(pub->tklock);
+    }
+    g_slist_free_full(pub->clients, mce_shm_client_free1);
+    if (pub->sock_id) {
+        g_source_remove(pub->sock_id);
+    }
+    if (pub->sock >= 0) {
+        close(pub->sock);
+    }
+    if (pub->page) {
+        munmap(pub->page, MCE_SHM_PAGE_SIZE);
+    }
+    if (pub->rofd >= 0) {
+        close(pub->rofd);
+    }
+    if (pub->memfd >= 0) {
+        close(pub->memfd);
+    }
+    g_slice_free(MceShmPublisher, pub);
+}
+
+static
+gboolean
+mce_shm_publisher_init(
+    MceShmPublisher* pub)
+{
+    struct sockaddr_un sa;
+    const socklen_t len = mce_shm_address(&sa);
+    char path[32];
+    void* page;
+
+    pub->memfd = memfd_create(MCE_SHM_SOCKET, MFD_CLOEXEC |
+        MFD_ALLOW_SEALING);
+    if (pub->memfd < 0 || ftruncate(pub->memfd, MCE_SHM_PAGE_SIZE) < 0 ||
+        fcntl(pub->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+        F_SEAL_SEAL) < 0) {
+        return FALSE;
+    }
+
+    page = mmap(NULL, MCE_SHM_PAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_SHARED, pub->memfd, 0);
+    if (page == MAP_FAILED) {
+        return FALSE;
+    }
+    pub->page = page;
+    pub->page->magic = MCE_SHM_MAGIC;
+    pub->page->version = MCE_SHM_VERSION;
+
+    /* Readers get a read-only descriptor, they can't map it writable */
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", pub->memfd);
+    pub->rofd = open(path, O_RDONLY | O_CLOEXEC);
+    if (pub->rofd < 0) {
+        return FALSE;
+    }
+
+    pub->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+        0);
+    if (pub->sock < 0 || bind(pub->sock, (struct sockaddr*)&sa, len) < 0 ||
+        listen(pub->sock, SOMAXCONN) < 0) {
+        return FALSE;
+    }
+    pub->sock_id = g_unix_fd_add(pub->sock, G_IO_IN,
+        mce_shm_publisher_accept, pub);
+    return TRUE;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+gboolean
+mce_shm_publish(
+    GError** error)
+{
+    if (!mce_shm_publisher) {
+        MceShmPublisher* pub = g_slice_new0(MceShmPublisher);
+
+        pub->memfd = pub->rofd = pub->sock = -1;
+        if (!mce_shm_publisher_init(pub)) {
+            const int err = errno;
+
+            g_set_error(error, G_IO_ERROR, g_io_error_from_errno(err),
+                "Failed to publish MCE state: %s", strerror(err));
+            mce_shm_publisher_free(pub);
+            return FALSE;
+        }
+
+        /* Must be set before creating the objects, see mce_shm_attach */
+        mce_shm_publisher = pub;
+        pub->display = mce_display_new();
+
+        /* These aren't timed like the handlers of the clients */
+        pub->display_event_id[DISPLAY_EVENT_VALID] =
+            g_signal_connect(pub->display, "mce-display-valid-changed",
+                G_CALLBACK(mce_shm_publisher_display_changed), pub);
+        pub->display_event_id[DISPLAY_EVENT_STATE] =
+            g_signal_connect(pub->display, "mce-display-state-changed",
+                G_CALLBACK(mce_shm_publisher_display_changed), pub);
+        pub->tklock = mce_tklock_new();
+        pub->tklock_event_id[TKLOCK_EVENT_VALID] =
+            g_signal_connect(pub->tklock, "mce-tklock-valid-changed",
+                G_CALLBACK(mce_shm_publisher_tklock_changed), pub);
+        pub->tklock_event_id[TKLOCK_EVENT_MODE] =
+            g_signal_connect(pub->tklock, "mce-tklock-mode-changed",
+                G_CALLBACK(mce_shm_publisher_tklock_changed), pub);
+        pub->tklock_event_id[TKLOCK_EVENT_LOCKED] =
+            g_signal_connect(pub->tklock, "mce-tklock-locked-changed",
+                G_CALLBACK(mce_shm_publisher_tklock_changed), pub);
+        mce_shm_publisher_update(pub);
+        GDEBUG("Publishing MCE state");
+    }
+    return TRUE;
+}
+
+void
+mce_shm_unpublish(
+    void)
+{
+    if (mce_shm_publisher) {
+        MceShmPublisher* pub = mce_shm_publisher;
+
+        /* Readers get HUP and fall back to D-Bus */
+        mce_shm_publisher = NULL;
+        mce_shm_publisher_free(pub);
+    }
+}
+
+void
+mce_shm_set_enabled(
+    gboolean enabled)
+{
+    mce_shm_reader_enabled = enabled;
+}
+
+gboolean
+mce_shm_enabled(
+    void)
+{
+    return mce_shm_reader_enabled;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
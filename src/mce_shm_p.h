@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_SHM_PRIVATE_H
+#define MCE_SHM_PRIVATE_H
+
+#include "mce_shm.h"
+
+typedef struct mce_shm MceShm;
+
+typedef struct mce_shm_state {
+    gboolean display_valid;
+    gint display_state;
+    gboolean tklock_valid;
+    gint tklock_mode;
+    gboolean tklock_locked;
+} MceShmState;
+
+typedef void
+(*MceShmFunc)(
+    MceShm* shm,
+    void* arg);
+
+/*
+ * Returns NULL if the shared mode is disabled or there's no publisher.
+ * The changed callback is invoked when the state page has been received
+ * and every time it gets updated. The lost callback is invoked when the
+ * publisher disappears, after which the caller is expected to detach.
+ */
+MceShm*
+mce_shm_attach(
+    MceShmFunc changed,
+    MceShmFunc lost,
+    void* arg);
+
+void
+mce_shm_detach(
+    MceShm* shm);
+
+/*
+ * Returns FALSE if no consistent snapshot could be taken, which means
+ * that the publisher is broken. The caller should then detach and talk
+ * to MCE directly.
+ */
+gboolean
+mce_shm_read(
+    MceShm* shm,
+    MceShmState* state);
+
+#endif /* MCE_SHM_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
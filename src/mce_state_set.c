@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_state_set.h"
+#include "mce_log_p.h"
+
+#include <string.h>
+
+#define MCE_STATE_MAX_SIGNALS (3)
+
+typedef struct mce_state_source {
+    const char* type_name;
+    MCE_STATE_MEMBER member;
+    const char* signal[MCE_STATE_MAX_SIGNALS];
+    void (*fill)(gpointer object, MceStateSnapshot* snapshot);
+} MceStateSource;
+
+typedef struct mce_state_sub {
+    MceStateSet* set;
+    GObject* object;
+    const MceStateSource* source;
+    gulong id[MCE_STATE_MAX_SIGNALS];
+} MceStateSub;
+
+struct mce_state_set {
+    MceStateSetFunc fn;
+    void* arg;
+    GSList* subs;
+    guint changed;
+    guint flush_id;
+};
+
+/*==========================================================================*
+ * Sources
+ *==========================================================================*/
+
+static
+void
+mce_state_display_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceDisplay* display = object;
+
+    if (display->valid) {
+        snapshot->valid |= MCE_STATE_DISPLAY;
+    }
+    snapshot->display_state = display->state;
+}
+
+static
+void
+mce_state_tklock_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceTklock* tklock = object;
+
+    if (tklock->valid) {
+        snapshot->valid |= MCE_STATE_TKLOCK;
+    }
+    snapshot->tklock_mode = tklock->mode;
+    snapshot->tklock_locked = tklock->locked;
+}
+
+static
+void
+mce_state_battery_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceBattery* battery = object;
+
+    if (battery->valid) {
+        snapshot->valid |= MCE_STATE_BATTERY;
+    }
+    snapshot->battery_level = battery->level;
+    snapshot->battery_status = battery->status;
+}
+
+static
+void
+mce_state_charger_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceCharger* charger = object;
+
+    if (charger->valid) {
+        snapshot->valid |= MCE_STATE_CHARGER;
+    }
+    snapshot->charger_state = charger->state;
+}
+
+static
+void
+mce_state_call_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceCallState* call = object;
+
+    if (call->valid) {
+        snapshot->valid |= MCE_STATE_CALL_STATE;
+    }
+    snapshot->call_state = call->state;
+    snapshot->call_type = call->type;
+}
+
+static
+void
+mce_state_inactivity_fill(
+    gpointer object,
+    MceStateSnapshot* snapshot)
+{
+    MceInactivity* inactivity = object;
+
+    if (inactivity->valid) {
+        snapshot->valid |= MCE_STATE_INACTIVITY;
+    }
+    snapshot->inactive = inactivity->status;
+}
+
+static const MceStateSource mce_state_sources[] = {
+    { "MceDisplay", MCE_STATE_DISPLAY,
+      { "mce-display-valid-changed",
+        "mce-display-state-changed" },
+      mce_state_display_fill },
+    { "MceTklock", MCE_STATE_TKLOCK,
+      { "mce-tklock-valid-changed",
+        "mce-tklock-mode-changed",
+        "mce-tklock-locked-changed" },
+      mce_state_tklock_fill },
+    { "MceBattery", MCE_STATE_BATTERY,
+      { "mce-battery-valid-changed",
+        "mce-battery-level-changed",
+        "mce-battery-status-changed" },
+      mce_state_battery_fill },
+    { "MceCharger", MCE_STATE_CHARGER,
+      { "mce-charger-valid-changed",
+        "mce-charger-state-changed" },
+      mce_state_charger_fill },
+    { "MceCallState", MCE_STATE_CALL_STATE,
+      { "mce-call-state-valid-changed",
+        "mce-call-state-state-changed",
+        "mce-call-state-type-changed" },
+      mce_state_call_fill },
+    { "MceInactivity", MCE_STATE_INACTIVITY,
+      { "mce-inactivity-valid-changed",
+        "mce-inactivity-status-changed" },
+      mce_state_inactivity_fill }
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_state_set_fill(
+    MceStateSet* self,
+    MceStateSnapshot* snapshot)
+{
+    GSList* l;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->changed = self->changed;
+    for (l = self->subs; l; l = l->next) {
+        const MceStateSub* sub = l->data;
+
+        snapshot->members |= sub->source->member;
+        sub->source->fill(sub->object, snapshot);
+    }
+}
+
+static
+gboolean
+mce_state_set_flush(
+    gpointer data)
+{
+    MceStateSet* self = data;
+    MceStateSnapshot snapshot;
+
+    self->flush_id = 0;
+    mce_state_set_fill(self, &snapshot);
+    self->changed = 0;
+    self->fn(self, &snapshot, self->arg);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_state_set_changed(
+    MceStateSet* self,
+    MCE_STATE_MEMBER member)
+{
+    self->changed |= member;
+    if (!self->flush_id) {
+        /*
+         * Signals already queued at the same priority get dispatched
+         * before this source, in the same main loop iteration.
+         */
+        self->flush_id = g_idle_add_full(G_PRIORITY_DEFAULT,
+            mce_state_set_flush, self, NULL);
+    }
+}
+
+static
+void
+mce_state_set_signal(
+    GObject* object,
+    gpointer data)
+{
+    MceStateSub* sub = data;
+
+    mce_state_set_changed(sub->set, sub->source->member);
+}
+
+static
+MceStateSub*
+mce_state_set_find(
+    MceStateSet* self,
+    gpointer object)
+{
+    GSList* l;
+
+    for (l = self->subs; l; l = l->next) {
+        MceStateSub* sub = l->data;
+
+        if (sub->object == object) {
+            return sub;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+mce_state_set_sub_free(
+    MceStateSub* sub)
+{
+    guint i;
+
+    for (i = 0; i < MCE_STATE_MAX_SIGNALS; i++) {
+        if (sub->id[i]) {
+            g_signal_handler_disconnect(sub->object, sub->id[i]);
+        }
+    }
+    g_object_unref(sub->object);
+    g_slice_free(MceStateSub, sub);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceStateSet*
+mce_state_set_new(
+    MceStateSetFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(fn)) {
+        MceStateSet* self = g_slice_new0(MceStateSet);
+
+        self->fn = fn;
+        self->arg = arg;
+        return self;
+    }
+    return NULL;
+}
+
+void
+mce_state_set_free(
+    MceStateSet* self)
+{
+    if (G_LIKELY(self)) {
+        if (self->flush_id) {
+            g_source_remove(self->flush_id);
+        }
+        g_slist_free_full(self->subs, (GDestroyNotify)
+            mce_state_set_sub_free);
+        g_slice_free(MceStateSet, self);
+    }
+}
+
+gboolean
+mce_state_set_add(
+    MceStateSet* self,
+    gpointer object)
+{
+    if (G_LIKELY(self) && G_IS_OBJECT(object)) {
+        const char* type_name = G_OBJECT_TYPE_NAME(object);
+        guint i;
+
+        if (mce_state_set_find(self, object)) {
+            return TRUE;
+        }
+
+        for (i = 0; i < G_N_ELEMENTS(mce_state_sources); i++) {
+            const MceStateSource* source = mce_state_sources + i;
+
+            if (!strcmp(source->type_name, type_name)) {
+                MceStateSub* sub = g_slice_new0(MceStateSub);
+                guint k;
+
+                sub->set = self;
+                sub->object = g_object_ref(object);
+                sub->source = source;
+                for (k = 0; k < MCE_STATE_MAX_SIGNALS &&
+                         source->signal[k]; k++) {
+                    sub->id[k] = g_signal_connect(object, source->signal[k],
+                        G_CALLBACK(mce_state_set_signal), sub);
+                }
+                self->subs = g_slist_append(self->subs, sub);
+                mce_state_set_changed(self, source->member);
+                return TRUE;
+            }
+        }
+        GWARN("Unsupported object type %s", type_name);
+    }
+    return FALSE;
+}
+
+void
+mce_state_set_remove(
+    MceStateSet* self,
+    gpointer object)
+{
+    MceStateSub* sub = G_LIKELY(self) ? mce_state_set_find(self, object) :
+        NULL;
+
+    if (sub) {
+        const MCE_STATE_MEMBER member = sub->source->member;
+
+        self->subs = g_slist_remove(self->subs, sub);
+        mce_state_set_sub_free(sub);
+        mce_state_set_changed(self, member);
+    }
+}
+
+void
+mce_state_set_get(
+    MceStateSet* self,
+    MceStateSnapshot* snapshot)
+{
+    if (G_LIKELY(self) && G_LIKELY(snapshot)) {
+        mce_state_set_fill(self, snapshot);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,556 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_tklock.h"
+#include "mce_defer.h"
+#include "mce_handler_p.h"
+#include "mce_cache_p.h"
+#include "mce_proxy.h"
+#include "mce_shm_p.h"
+#include "mce_linger_p.h"
+#include "mce_log_p.h"
+
+#include <gutil_misc.h>
+
+struct mce_tklock_priv {
+    MceShm* shm;
+    MceProxy* proxy;
+    gulong proxy_valid_id;
+    guint tklock_mode_ind_id;
+};
+
+enum mce_tklock_signal {
+    SIGNAL_VALID_CHANGED,
+    SIGNAL_MODE_CHANGED,
+    SIGNAL_LOCKED_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_VALID_CHANGED_NAME   "mce-tklock-valid-changed"
+#define SIGNAL_MODE_CHANGED_NAME    "mce-tklock-mode-changed"
+#define SIGNAL_LOCKED_CHANGED_NAME  "mce-tklock-locked-changed"
+
+/* Assume locked until we know better */
+#define MCE_TKLOCK_MODE_DEFAULT MCE_TKLOCK_MODE_LOCKED
+
+static guint mce_tklock_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceTklockClass;
+G_DEFINE_TYPE(MceTklock, mce_tklock, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_tklock_parent_class
+#define MCE_TKLOCK_TYPE (mce_tklock_get_type())
+#define MCE_TKLOCK(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_TKLOCK_TYPE,MceTklock))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+gboolean
+mce_tklock_mode_locked(
+    MCE_TKLOCK_MODE mode)
+{
+    return mode != MCE_TKLOCK_MODE_UNLOCKED &&
+        mode != MCE_TKLOCK_MODE_SILENT_UNLOCKED;
+}
+
+static
+void
+mce_tklock_mode_update(
+    MceTklock* self,
+    MCE_TKLOCK_MODE mode)
+{
+    const gboolean locked = mce_tklock_mode_locked(mode);
+    MceTklockPriv* priv = self->priv;
+
+    if (priv->proxy && (self->mode != mode || !self->valid)) {
+        mce_cache_set(MCE_CACHE_TKLOCK_MODE, mode);
+    }
+    /* Confirmed or corrected by MCE */
+    self->provisional = FALSE;
+    if (self->mode != mode) {
+        self->mode = mode;
+        g_signal_emit(self, mce_tklock_signals[SIGNAL_MODE_CHANGED], 0);
+    }
+    if (self->locked != locked) {
+        self->locked = locked;
+        g_signal_emit(self, mce_tklock_signals[SIGNAL_LOCKED_CHANGED], 0);
+    }
+    /* Without the proxy, the state comes from the valid shared page */
+    if ((!priv->proxy || priv->proxy->valid) && !self->valid) {
+        self->valid = TRUE;
+        g_signal_emit(self, mce_tklock_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_tklock_unsupported(
+    MceTklock* self)
+{
+    /*
+     * The backend has nothing to say about tklock, meaning that
+     * the cached mode would never get confirmed. Forget it.
+     */
+    if (self->provisional) {
+        const MCE_TKLOCK_MODE mode = MCE_TKLOCK_MODE_DEFAULT;
+        const gboolean locked = mce_tklock_mode_locked(mode);
+
+        GDEBUG("Dropping provisional tklock mode");
+        self->provisional = FALSE;
+        if (self->mode != mode) {
+            self->mode = mode;
+            g_signal_emit(self, mce_tklock_signals[SIGNAL_MODE_CHANGED], 0);
+        }
+        if (self->locked != locked) {
+            self->locked = locked;
+            g_signal_emit(self,
+                mce_tklock_signals[SIGNAL_LOCKED_CHANGED], 0);
+        }
+    }
+}
+
+static
+void
+mce_tklock_mode_query_done(
+    MceProxy* proxy,
+    GVariant* result,
+    const GError* error,
+    void* arg)
+{
+    MceTklock* self = MCE_TKLOCK(arg);
+
+    if (self->priv->proxy != proxy) {
+        /* Switched to the shared page, it's the one to believe now */
+        GDEBUG("Ignoring tklock mode reply");
+    } else if (result && proxy->backend) {
+        const int mode = proxy->backend->tklock_mode(result);
+
+        GDEBUG("Tklock is currently %d", mode);
+        mce_tklock_mode_update(self, mode);
+    } else {
+        /* tklock_mode_ind will eventually bring us in sync */
+        GWARN("Failed to query tklock mode %s", GERRMSG(error));
+    }
+    mce_tklock_unref(self);
+}
+
+static
+void
+mce_tklock_mode_ind(
+    GDBusConnection* bus,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* name,
+    GVariant* args,
+    gpointer arg)
+{
+    MceTklock* self = MCE_TKLOCK(arg);
+    const MceBackend* backend = self->priv->proxy->backend;
+    int mode;
+
+    if (!g_variant_is_of_type(args,
+        G_VARIANT_TYPE(backend->tklock_signature))) {
+        GWARN("Unexpected %s signature %s", name,
+            g_variant_get_type_string(args));
+        return;
+    }
+    mode = backend->tklock_mode(args);
+    GDEBUG("Tklock is %d", mode);
+    mce_tklock_mode_update(self, mode);
+}
+
+static
+void
+mce_tklock_mode_query(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+    const MceBackend* backend = proxy->backend;
+
+    /* Not every backend knows about tklock */
+    if (backend && backend->tklock_signal) {
+        if (!priv->tklock_mode_ind_id) {
+            priv->tklock_mode_ind_id = mce_proxy_subscribe(proxy,
+                backend->tklock_signal, mce_tklock_mode_ind, self);
+        }
+        if (proxy->valid) {
+            mce_proxy_call(proxy, backend->request(proxy),
+                backend->tklock_query, NULL,
+                G_VARIANT_TYPE(backend->tklock_reply),
+                mce_tklock_mode_query_done, mce_tklock_ref(self));
+        }
+    } else if (backend) {
+        mce_tklock_unsupported(self);
+    }
+}
+
+static
+void
+mce_tklock_invalidate(
+    MceTklock* self)
+{
+    if (self->valid) {
+        self->valid = FALSE;
+        g_signal_emit(self, mce_tklock_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+void
+mce_tklock_shm_changed(
+    MceShm* shm,
+    void* arg);
+
+static
+void
+mce_tklock_shm_lost(
+    MceShm* shm,
+    void* arg);
+
+static
+void
+mce_tklock_valid_changed(
+    MceProxy* proxy,
+    void* arg)
+{
+    MceTklock* self = MCE_TKLOCK(arg);
+
+    if (proxy->valid) {
+        MceTklockPriv* priv = self->priv;
+
+        /* The publisher may have come back together with MCE */
+        if (!priv->shm) {
+            priv->shm = mce_shm_attach(mce_tklock_shm_changed,
+                mce_tklock_shm_lost, self);
+        }
+        mce_tklock_mode_query(self);
+    } else {
+        MceTklockPriv* priv = self->priv;
+
+        /* The subscription doesn't survive reconnect */
+        mce_proxy_unsubscribe(proxy, priv->tklock_mode_ind_id);
+        priv->tklock_mode_ind_id = 0;
+        mce_tklock_invalidate(self);
+    }
+}
+
+static
+void
+mce_tklock_proxy_attach(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = self->priv;
+
+    GASSERT(!priv->proxy);
+    priv->proxy = mce_proxy_new();
+    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
+        mce_tklock_valid_changed, self);
+    mce_tklock_mode_query(self);
+}
+
+static
+void
+mce_tklock_proxy_detach(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = self->priv;
+
+    if (priv->proxy) {
+        mce_proxy_unsubscribe(priv->proxy, priv->tklock_mode_ind_id);
+        mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+        mce_proxy_unref(priv->proxy);
+        priv->tklock_mode_ind_id = 0;
+        priv->proxy_valid_id = 0;
+        priv->proxy = NULL;
+    }
+}
+
+static
+void
+mce_tklock_shm_lost(
+    MceShm* shm,
+    void* arg)
+{
+    MceTklock* self = MCE_TKLOCK(arg);
+    MceTklockPriv* priv = self->priv;
+
+    mce_shm_detach(priv->shm);
+    priv->shm = NULL;
+    if (!priv->proxy) {
+        /* Fall back to talking to MCE directly */
+        mce_tklock_invalidate(self);
+        mce_tklock_proxy_attach(self);
+    }
+}
+
+static
+void
+mce_tklock_shm_changed(
+    MceShm* shm,
+    void* arg)
+{
+    MceTklock* self = MCE_TKLOCK(arg);
+    MceShmState state;
+
+    if (mce_shm_read(shm, &state)) {
+        /* Attached after falling back to D-Bus */
+        mce_tklock_proxy_detach(self);
+        if (state.tklock_valid) {
+            mce_tklock_mode_update(self, state.tklock_mode);
+        } else {
+            mce_tklock_invalidate(self);
+        }
+    } else {
+        mce_tklock_shm_lost(shm, self);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceTklock*
+mce_tklock_new()
+{
+    static MceTklock* mce_tklock_instance = NULL;
+
+    if (mce_tklock_instance) {
+        if (!mce_linger_revive(mce_tklock_instance)) {
+            mce_tklock_ref(mce_tklock_instance);
+        }
+    } else {
+        MceTklockPriv* priv;
+
+        mce_tklock_instance = g_object_new(MCE_TKLOCK_TYPE, NULL);
+        priv = mce_tklock_instance->priv;
+        priv->shm = mce_shm_attach(mce_tklock_shm_changed,
+            mce_tklock_shm_lost, mce_tklock_instance);
+        if (!priv->shm) {
+            int mode;
+
+            /* Serve the last known mode until MCE confirms it */
+            if (mce_cache_get(MCE_CACHE_TKLOCK_MODE, MCE_TKLOCK_MODE_LOCKED,
+                MCE_TKLOCK_MODE_SILENT_UNLOCKED, &mode)) {
+                mce_tklock_instance->mode = mode;
+                mce_tklock_instance->locked = mce_tklock_mode_locked(mode);
+                mce_tklock_instance->provisional = TRUE;
+            }
+            mce_tklock_proxy_attach(mce_tklock_instance);
+        }
+        g_object_add_weak_pointer(G_OBJECT(mce_tklock_instance),
+            (gpointer*)(&mce_tklock_instance));
+    }
+    return mce_tklock_instance;
+}
+
+MceTklock*
+mce_tklock_ref(
+    MceTklock* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_TKLOCK(self));
+    }
+    return self;
+}
+
+void
+mce_tklock_unref(
+    MceTklock* self)
+{
+    if (G_LIKELY(self) && !mce_linger_unref(self)) {
+        g_object_unref(MCE_TKLOCK(self));
+    }
+}
+
+gulong
+mce_tklock_add_valid_changed_handler(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_tklock_add_mode_changed_handler(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_MODE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_tklock_add_locked_changed_handler(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_handler_connect(self,
+        SIGNAL_LOCKED_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
+gulong
+mce_tklock_add_valid_changed_handler_full(
+    MceTklock* self,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_tklock_add_valid_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_tklock_add_mode_changed_handler_full(
+    MceTklock* self,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_MODE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_tklock_add_mode_changed_handler(self, fn, arg);
+    }
+}
+
+gulong
+mce_tklock_add_locked_changed_handler_full(
+    MceTklock* self,
+    MCE_PRIORITY priority,
+    MceTklockFunc fn,
+    void* arg)
+{
+    if (priority == MCE_PRIORITY_DEFERRABLE) {
+        return (G_LIKELY(self) && G_LIKELY(fn)) ? mce_defer_connect(self,
+            SIGNAL_LOCKED_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    } else {
+        return mce_tklock_add_locked_changed_handler(self, fn, arg);
+    }
+}
+
+void
+mce_tklock_remove_handler(
+    MceTklock* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        g_signal_handler_disconnect(self, id);
+    }
+}
+
+void
+mce_tklock_remove_handlers(
+    MceTklock* self,
+    gulong *ids,
+    guint count)
+{
+    gutil_disconnect_handlers(self, ids, count);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_tklock_init(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_TKLOCK_TYPE,
+        MceTklockPriv);
+
+    self->priv = priv;
+    self->mode = MCE_TKLOCK_MODE_DEFAULT;
+    self->locked = mce_tklock_mode_locked(self->mode);
+}
+
+static
+void
+mce_tklock_finalize(
+    GObject* object)
+{
+    MceTklock* self = MCE_TKLOCK(object);
+    MceTklockPriv* priv = self->priv;
+
+    mce_shm_detach(priv->shm);
+    mce_tklock_proxy_detach(self);
+    mce_cache_flush();
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_tklock_class_init(
+    MceTklockClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_tklock_finalize;
+    g_type_class_add_private(klass, sizeof(MceTklockPriv));
+    mce_tklock_signals[SIGNAL_VALID_CHANGED] =
+        g_signal_new(SIGNAL_VALID_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_tklock_signals[SIGNAL_MODE_CHANGED] =
+        g_signal_new(SIGNAL_MODE_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_tklock_signals[SIGNAL_LOCKED_CHANGED] =
+        g_signal_new(SIGNAL_LOCKED_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_TRACE_PRIVATE_H
+#define MCE_TRACE_PRIVATE_H
+
+/*
+ * Static (USDT) tracepoints, usable with perf, bpftrace, SystemTap
+ * and such. They are compiled in if <sys/sdt.h> is available at
+ * build time (unless HAVE_SDT is defined to zero) and cost a single
+ * nop each when nobody is tracing. List them with e.g.
+ *
+ *   readelf -n libmce-glib.so.1 | grep -A2 stapsdt
+ *
+ * Provider name is libmce_glib.
+ */
+
+#if !defined(HAVE_SDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    define HAVE_SDT 1
+#  endif
+#endif
+
+#if HAVE_SDT
+#  include <sys/sdt.h>
+#  define MCE_TRACE0(name) \
+    DTRACE_PROBE(libmce_glib, name)
+#  define MCE_TRACE1(name,a) \
+    DTRACE_PROBE1(libmce_glib, name, a)
+#  define MCE_TRACE2(name,a,b) \
+    DTRACE_PROBE2(libmce_glib, name, a, b)
+#  define MCE_TRACE3(name,a,b,c) \
+    DTRACE_PROBE3(libmce_glib, name, a, b, c)
+#else
+#  define MCE_TRACE0(name) ((void)0)
+#  define MCE_TRACE1(name,a) ((void)0)
+#  define MCE_TRACE2(name,a,b) ((void)0)
+#  define MCE_TRACE3(name,a,b,c) ((void)0)
+#endif
+
+#endif /* MCE_TRACE_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
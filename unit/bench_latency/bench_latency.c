@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+
+/* Generated headers */
+#include "com.canonical.Unity.Screen.h"
+
+#include <string.h>
+
+/*
+ * Measures how long a display state change takes to reach the state
+ * handler while the shared system bus connection of the same process
+ * is busy with bulk traffic, with and without the private connection.
+ */
+
+#define BENCH_ROUNDS (20)
+#define BENCH_BULK_COUNT (32)
+#define BENCH_BULK_SIZE (64 * 1024)
+#define BENCH_BULK_PATH "/bench"
+#define BENCH_BULK_INTERFACE "org.example.Bulk"
+#define BENCH_BULK_SIGNAL "Data"
+
+typedef struct bench_provider {
+    GThread* thread;
+    GMainContext* context;
+    GMainLoop* loop;
+    GDBusConnection* conn;
+    ComCanonicalUnityScreen* skeleton;
+    GMutex mutex;
+    GCond cond;
+    gboolean ready;
+    gint state;
+    gint64 sent;
+} BenchProvider;
+
+typedef struct bench {
+    BenchProvider provider;
+    MceDisplay* display;
+    MCE_DISPLAY_STATE expected;
+    gint64 latency[BENCH_ROUNDS];
+    guint round;
+    guint64 bulk_bytes;
+} Bench;
+
+/*==========================================================================*
+ * Provider thread
+ *==========================================================================*/
+
+static
+gboolean
+bench_provider_get_state(
+    ComCanonicalUnityScreen* skeleton,
+    GDBusMethodInvocation* call,
+    gpointer arg)
+{
+    BenchProvider* provider = arg;
+
+    com_canonical_unity_screen_complete_get_display_power_state(skeleton,
+        call, provider->state);
+    return TRUE;
+}
+
+static
+void
+bench_provider_name_acquired(
+    GDBusConnection* conn,
+    const gchar* name,
+    gpointer arg)
+{
+    BenchProvider* provider = arg;
+
+    g_mutex_lock(&provider->mutex);
+    provider->ready = TRUE;
+    g_cond_signal(&provider->cond);
+    g_mutex_unlock(&provider->mutex);
+}
+
+static
+gpointer
+bench_provider_thread(
+    gpointer arg)
+{
+    BenchProvider* provider = arg;
+    GError* error = NULL;
+    guint own_id;
+
+    g_main_context_push_thread_default(provider->context);
+    provider->conn = g_dbus_connection_new_for_address_sync
+        (g_getenv("DBUS_SYSTEM_BUS_ADDRESS"),
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION, NULL, NULL, &error);
+    g_assert_no_error(error);
+    provider->skeleton = com_canonical_unity_screen_skeleton_new();
+    g_signal_connect(provider->skeleton, "handle-get-display-power-state",
+        G_CALLBACK(bench_provider_get_state), provider);
+    g_assert(g_dbus_interface_skeleton_export
+        (G_DBUS_INTERFACE_SKELETON(provider->skeleton), provider->conn,
+        MCE_REQUEST_PATH, NULL));
+    own_id = g_bus_own_name_on_connection(provider->conn, MCE_SERVICE,
+        G_BUS_NAME_OWNER_FLAGS_REPLACE, bench_provider_name_acquired,
+        NULL, provider, NULL);
+    g_main_loop_run(provider->loop);
+    g_bus_unown_name(own_id);
+    g_dbus_interface_skeleton_unexport
+        (G_DBUS_INTERFACE_SKELETON(provider->skeleton));
+    g_object_unref(provider->skeleton);
+    g_dbus_connection_close_sync(provider->conn, NULL, NULL);
+    g_object_unref(provider->conn);
+    g_main_context_pop_thread_default(provider->context);
+    return NULL;
+}
+
+static
+gboolean
+bench_provider_round(
+    gpointer arg)
+{
+    BenchProvider* provider = arg;
+    guint8* data = g_malloc0(BENCH_BULK_SIZE);
+    int i;
+
+    /* Bulk traffic first, then the display signal right behind it */
+    for (i = 0; i < BENCH_BULK_COUNT; i++) {
+        g_dbus_connection_emit_signal(provider->conn, NULL, BENCH_BULK_PATH,
+            BENCH_BULK_INTERFACE, BENCH_BULK_SIGNAL, g_variant_new("(@ay)",
+            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data,
+            BENCH_BULK_SIZE, 1)), NULL);
+    }
+    g_free(data);
+    provider->state = !provider->state;
+    g_mutex_lock(&provider->mutex);
+    provider->sent = g_get_monotonic_time();
+    g_mutex_unlock(&provider->mutex);
+    g_dbus_connection_emit_signal(provider->conn, NULL, MCE_SIGNAL_PATH,
+        MCE_INTERFACE, "DisplayPowerStateChange",
+        g_variant_new("(ii)", provider->state, 0), NULL);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+bench_provider_start(
+    BenchProvider* provider)
+{
+    g_mutex_init(&provider->mutex);
+    g_cond_init(&provider->cond);
+    provider->state = 1;
+    provider->context = g_main_context_new();
+    provider->loop = g_main_loop_new(provider->context, FALSE);
+    provider->thread = g_thread_new("provider", bench_provider_thread,
+        provider);
+    g_mutex_lock(&provider->mutex);
+    while (!provider->ready) {
+        g_cond_wait(&provider->cond, &provider->mutex);
+    }
+    g_mutex_unlock(&provider->mutex);
+}
+
+static
+void
+bench_provider_stop(
+    BenchProvider* provider)
+{
+    g_main_loop_quit(provider->loop);
+    g_thread_join(provider->thread);
+    g_main_loop_unref(provider->loop);
+    g_main_context_unref(provider->context);
+    g_cond_clear(&provider->cond);
+    g_mutex_clear(&provider->mutex);
+}
+
+/*==========================================================================*
+ * Client
+ *==========================================================================*/
+
+static
+void
+bench_bulk(
+    GDBusConnection* conn,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* name,
+    GVariant* args,
+    gpointer arg)
+{
+    Bench* bench = arg;
+
+    /* Some other library chewing on its data */
+    bench->bulk_bytes += g_variant_get_size(args);
+}
+
+static
+void
+bench_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    Bench* bench = arg;
+
+    if (display->valid && display->state == bench->expected &&
+        bench->round < BENCH_ROUNDS) {
+        BenchProvider* provider = &bench->provider;
+        const gint64 now = g_get_monotonic_time();
+
+        g_mutex_lock(&provider->mutex);
+        bench->latency[bench->round] = now - provider->sent;
+        g_mutex_unlock(&provider->mutex);
+    }
+    test_check();
+}
+
+static
+gboolean
+bench_display_valid(
+    void* arg)
+{
+    Bench* bench = arg;
+
+    return bench->display->valid;
+}
+
+static
+gboolean
+bench_display_expected(
+    void* arg)
+{
+    Bench* bench = arg;
+
+    return bench->display->state == bench->expected;
+}
+
+static
+void
+bench_run(
+    gboolean private_bus)
+{
+    TestBus bus;
+    Bench bench;
+    GDBusConnection* shared;
+    gint64 min = G_MAXINT64, max = 0, total = 0;
+    guint bulk_id;
+    gulong id[2];
+    guint i;
+
+    memset(&bench, 0, sizeof(bench));
+    memset(&bus, 0, sizeof(bus));
+    test_bus_up(&bus);
+    bench_provider_start(&bench.provider);
+
+    /* Some other library is receiving bulk data over the shared bus */
+    shared = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
+    g_assert(shared);
+    bulk_id = g_dbus_connection_signal_subscribe(shared, NULL,
+        BENCH_BULK_INTERFACE, BENCH_BULK_SIGNAL, BENCH_BULK_PATH, NULL,
+        G_DBUS_SIGNAL_FLAGS_NONE, bench_bulk, &bench, NULL);
+
+    mce_bus_set_backend(MCE_BACKEND_UNITY);
+    mce_bus_set_private(private_bus);
+    bench.display = mce_display_new();
+    id[0] = mce_display_add_valid_changed_handler(bench.display,
+        bench_display_changed, &bench);
+    id[1] = mce_display_add_state_changed_handler(bench.display,
+        bench_display_changed, &bench);
+    test_run_until(bench_display_valid, &bench);
+
+    for (bench.round = 0; bench.round < BENCH_ROUNDS; bench.round++) {
+        bench.expected = (bench.display->state == MCE_DISPLAY_STATE_OFF) ?
+            MCE_DISPLAY_STATE_ON : MCE_DISPLAY_STATE_OFF;
+        g_main_context_invoke(bench.provider.context, bench_provider_round,
+            &bench.provider);
+        test_run_until(bench_display_expected, &bench);
+    }
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        const gint64 t = bench.latency[i];
+
+        total += t;
+        if (min > t) min = t;
+        if (max < t) max = t;
+    }
+    g_print("%s connection: latency min %u us, avg %u us, max %u us "
+        "(%u x %u KiB of bulk data per signal)\n",
+        private_bus ? "Private" : "Shared", (guint)min,
+        (guint)(total / BENCH_ROUNDS), (guint)max, BENCH_BULK_COUNT,
+        BENCH_BULK_SIZE / 1024);
+
+    mce_display_remove_all_handlers(bench.display, id);
+    mce_display_unref(bench.display);
+    g_dbus_connection_signal_unsubscribe(shared, bulk_id);
+    g_object_unref(shared);
+    bench_provider_stop(&bench.provider);
+    test_bus_down(&bus);
+}
+
+static
+void
+bench_shared(
+    void)
+{
+    if (g_test_subprocess()) {
+        bench_run(FALSE);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, G_TEST_SUBPROCESS_INHERIT_STDOUT);
+    g_test_trap_assert_passed();
+}
+
+static
+void
+bench_private(
+    void)
+{
+    if (g_test_subprocess()) {
+        bench_run(TRUE);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, G_TEST_SUBPROCESS_INHERIT_STDOUT);
+    g_test_trap_assert_passed();
+}
+
+#define BENCH_(name) "/latency/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(BENCH_("shared"), bench_shared);
+    g_test_add_func(BENCH_("private"), bench_private);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
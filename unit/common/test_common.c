@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+static GMainLoop* test_loop = NULL;
+static TestCondition test_cond = NULL;
+static void* test_cond_arg = NULL;
+
+void
+test_bus_up(
+    TestBus* bus)
+{
+    GError* error = NULL;
+    const char* address;
+
+    bus->dbus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus->dbus);
+    address = g_test_dbus_get_bus_address(bus->dbus);
+    g_setenv("DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+    bus->conn = g_dbus_connection_new_for_address_sync(address,
+        G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+        G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert(bus->conn);
+}
+
+void
+test_bus_down(
+    TestBus* bus)
+{
+    if (bus->conn) {
+        g_dbus_connection_close_sync(bus->conn, NULL, NULL);
+        g_object_unref(bus->conn);
+        bus->conn = NULL;
+    }
+    g_test_dbus_down(bus->dbus);
+}
+
+GByteArray*
+test_record_new(
+    void)
+{
+    GByteArray* rec = g_byte_array_new();
+
+    g_byte_array_append(rec, (const guint8*)MCE_RECORD_MAGIC,
+        MCE_RECORD_MAGIC_SIZE);
+    return rec;
+}
+
+void
+test_record_add(
+    GByteArray* rec,
+    int type,
+    GVariant* payload)
+{
+    GVariant* data = g_variant_ref_sink(payload);
+    const guint64 time = 0;
+    guint32 size;
+    guint8 t = type;
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    GVariant* swapped = g_variant_byteswap(data);
+
+    g_variant_unref(data);
+    data = swapped;
+#endif
+
+    size = GUINT32_TO_LE(g_variant_get_size(data));
+    g_byte_array_append(rec, (const guint8*)&time, 8);
+    g_byte_array_append(rec, (const guint8*)&size, 4);
+    g_byte_array_append(rec, &t, 1);
+    g_byte_array_append(rec, g_variant_get_data(data),
+        g_variant_get_size(data));
+    g_variant_unref(data);
+}
+
+char*
+test_record_save(
+    GByteArray* rec)
+{
+    GError* error = NULL;
+    char* path = NULL;
+    const int fd = g_file_open_tmp("test_mce_XXXXXX", &path, &error);
+
+    g_assert_no_error(error);
+    close(fd);
+    g_assert(g_file_set_contents(path, (char*)rec->data, rec->len, NULL));
+    return path;
+}
+
+void
+test_provider_start(
+    TestProvider* provider,
+    GByteArray* rec)
+{
+    GError* error = NULL;
+
+    test_bus_up(&provider->bus);
+    provider->path = test_record_save(rec);
+    provider->replay = mce_replay_new(provider->bus.conn, provider->path,
+        &error);
+    g_assert_no_error(error);
+    g_assert(mce_replay_start(provider->replay, MCE_REPLAY_SPEED_FAST));
+    g_byte_array_free(rec, TRUE);
+}
+
+void
+test_provider_stop(
+    TestProvider* provider)
+{
+    mce_replay_stop(provider->replay);
+    mce_replay_unref(provider->replay);
+    provider->replay = NULL;
+    g_unlink(provider->path);
+    g_free(provider->path);
+    provider->path = NULL;
+    test_bus_down(&provider->bus);
+}
+
+void
+test_provider_emit(
+    TestProvider* provider,
+    const char* path,
+    const char* iface,
+    const char* name,
+    GVariant* args)
+{
+    g_assert(g_dbus_connection_emit_signal(provider->bus.conn, NULL, path,
+        iface, name, args, NULL));
+    g_assert(g_dbus_connection_flush_sync(provider->bus.conn, NULL, NULL));
+}
+
+GByteArray*
+test_record_unity(
+    gboolean display_on)
+{
+    GByteArray* rec = test_record_new();
+
+    test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+        (MCE_RECORD_NAME_APPEARED_PAYLOAD, MCE_SERVICE, ":1.1"));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, MCE_INTERFACE,
+        "getDisplayPowerState", g_variant_new("(i)", display_on != 0)));
+    return rec;
+}
+
+gboolean
+test_handler_stats(
+    GCallback fn,
+    void* arg,
+    MceHandlerStats* stats)
+{
+    const guint n = mce_handler_get_stats(NULL, 0);
+    MceHandlerStats* all = g_new(MceHandlerStats, n);
+    gboolean found = FALSE;
+    guint i;
+
+    mce_handler_get_stats(all, n);
+    for (i = 0; i < n && !found; i++) {
+        if (all[i].fn == fn && all[i].arg == arg) {
+            *stats = all[i];
+            found = TRUE;
+        }
+    }
+    g_free(all);
+    return found;
+}
+
+static
+gboolean
+test_timeout(
+    gpointer arg)
+{
+    g_assert_not_reached();
+    return G_SOURCE_REMOVE;
+}
+
+void
+test_check(
+    void)
+{
+    if (test_loop && test_cond(test_cond_arg)) {
+        g_main_loop_quit(test_loop);
+    }
+}
+
+void
+test_run_until(
+    TestCondition cond,
+    void* arg)
+{
+    if (!cond(arg)) {
+        const guint timeout_id = g_timeout_add_seconds(TEST_TIMEOUT_SEC,
+            test_timeout, NULL);
+
+        test_cond = cond;
+        test_cond_arg = arg;
+        test_loop = g_main_loop_new(NULL, FALSE);
+        g_main_loop_run(test_loop);
+        g_main_loop_unref(test_loop);
+        g_source_remove(timeout_id);
+        test_loop = NULL;
+        test_cond = NULL;
+        test_cond_arg = NULL;
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include "mce_handler.h"
+#include "mce_record.h"
+
+#include <gio/gio.h>
+
+#define TEST_TIMEOUT_SEC (10)
+
+/*
+ * Private dbus-daemon which the library under test treats as the
+ * system bus. Requires dbus-daemon to be installed.
+ */
+
+typedef struct test_bus {
+    GTestDBus* dbus;
+    GDBusConnection* conn; /* Connection of the provider */
+} TestBus;
+
+void
+test_bus_up(
+    TestBus* bus);
+
+void
+test_bus_down(
+    TestBus* bus);
+
+/* Recording in the mce_record_p.h format */
+
+GByteArray*
+test_record_new(
+    void);
+
+void
+test_record_add(
+    GByteArray* rec,
+    int type,
+    GVariant* payload);
+
+/* Writes the recording into a temporary file, returns its path */
+char*
+test_record_save(
+    GByteArray* rec);
+
+/*
+ * Bus plus the replay provider serving the recording on it. The
+ * recording is consumed. Signals can also be emitted on behalf of
+ * the provider at any time, they are flushed before returning.
+ */
+
+typedef struct test_provider {
+    TestBus bus;
+    char* path;
+    MceReplay* replay;
+} TestProvider;
+
+void
+test_provider_start(
+    TestProvider* provider,
+    GByteArray* rec);
+
+void
+test_provider_stop(
+    TestProvider* provider);
+
+void
+test_provider_emit(
+    TestProvider* provider,
+    const char* path,
+    const char* iface,
+    const char* name,
+    GVariant* args);
+
+/* Unity.Screen provider with the display in the given state */
+GByteArray*
+test_record_unity(
+    gboolean display_on);
+
+/* Stats of the handler with this function and argument (mce_handler.h) */
+gboolean
+test_handler_stats(
+    GCallback fn,
+    void* arg,
+    MceHandlerStats* stats);
+
+/* Runs the loop until the condition is met, fails on timeout */
+
+typedef
+gboolean
+(*TestCondition)(
+    void* arg);
+
+void
+test_run_until(
+    TestCondition cond,
+    void* arg);
+
+/* Re-checks the condition, to be called from the handlers */
+void
+test_check(
+    void);
+
+#endif /* TEST_COMMON_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_handler.h"
+#include "mce_proxy.h"
+
+#include <gutil_log.h>
+
+#include <errno.h>
+#include <string.h>
+
+/*
+ * Counts the allocations made by the main thread while a display state
+ * signal travels from the private connection to the state handler.
+ * The allocator functions defined here interpose the ones from libc for
+ * the whole process (the same way LD_PRELOAD would), GLib included.
+ * Allocations made by the GDBus worker thread are not counted.
+ */
+
+#define TEST_WARMUP_ROUNDS (5)
+#define TEST_ROUNDS (50)
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+static __thread gboolean test_alloc_counting = FALSE;
+static __thread guint test_alloc_count = 0;
+
+void*
+malloc(
+    size_t size)
+{
+    if (test_alloc_counting) {
+        test_alloc_count++;
+    }
+    return __libc_malloc(size);
+}
+
+void*
+calloc(
+    size_t nmemb,
+    size_t size)
+{
+    if (test_alloc_counting) {
+        test_alloc_count++;
+    }
+    return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(
+    void* ptr,
+    size_t size)
+{
+    if (test_alloc_counting) {
+        test_alloc_count++;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void*
+memalign(
+    size_t alignment,
+    size_t size)
+{
+    if (test_alloc_counting) {
+        test_alloc_count++;
+    }
+    return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(
+    void** ptr,
+    size_t alignment,
+    size_t size)
+{
+    if (test_alloc_counting) {
+        test_alloc_count++;
+    }
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+/*==========================================================================*
+ * Test
+ *==========================================================================*/
+
+typedef struct test_alloc {
+    TestProvider provider;
+    MceDisplay* display;
+} TestAlloc;
+
+static
+void
+test_alloc_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_alloc_ready(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_alloc_timeout(
+    gpointer arg)
+{
+    g_assert_not_reached();
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_alloc_run(
+    void)
+{
+    TestAlloc test;
+    guint i, total = 0, timeout_id;
+    gulong id[2];
+
+    gutil_log_default.level = GLOG_LEVEL_NONE;
+    memset(&test, 0, sizeof(test));
+    test_provider_start(&test.provider, test_record_unity(TRUE));
+
+    /* A slow handler would log a warning, which allocates */
+    mce_handler_set_budget(0);
+    mce_bus_set_backend(MCE_BACKEND_UNITY);
+    mce_bus_set_private(TRUE);
+    test.display = mce_display_new();
+    id[0] = mce_display_add_valid_changed_handler(test.display,
+        test_alloc_changed, NULL);
+    id[1] = mce_display_add_state_changed_handler(test.display,
+        test_alloc_changed, NULL);
+    test_run_until(test_alloc_ready, test.display);
+
+    timeout_id = g_timeout_add_seconds(TEST_TIMEOUT_SEC,
+        test_alloc_timeout, NULL);
+    for (i = 0; i < TEST_WARMUP_ROUNDS + TEST_ROUNDS; i++) {
+        const MCE_DISPLAY_STATE state =
+            (test.display->state == MCE_DISPLAY_STATE_ON) ?
+            MCE_DISPLAY_STATE_OFF : MCE_DISPLAY_STATE_ON;
+
+        /* Sending allocates, that's the provider's business */
+        test_provider_emit(&test.provider, MCE_SIGNAL_PATH, MCE_INTERFACE,
+            "DisplayPowerStateChange", g_variant_new("(ii)",
+            state == MCE_DISPLAY_STATE_ON, 0));
+
+        test_alloc_count = 0;
+        test_alloc_counting = TRUE;
+        while (test.display->state != state) {
+            g_main_context_iteration(NULL, TRUE);
+        }
+        test_alloc_counting = FALSE;
+        if (i >= TEST_WARMUP_ROUNDS) {
+            total += test_alloc_count;
+        } else {
+            g_test_message("Warm-up round %u: %u allocation(s)", i + 1,
+                test_alloc_count);
+        }
+    }
+    g_source_remove(timeout_id);
+    g_assert_cmpuint(total, == ,0);
+
+    mce_display_remove_all_handlers(test.display, id);
+    mce_display_unref(test.display);
+    test_provider_stop(&test.provider);
+}
+
+static
+void
+test_alloc(
+    void)
+{
+    if (g_test_subprocess()) {
+        test_alloc_run();
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/alloc/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("display"), test_alloc);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
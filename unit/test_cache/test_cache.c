@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_cache_p.h"
+#include "mce_display.h"
+#include "mce_tklock.h"
+
+#include <glib/gstdio.h>
+
+/*
+ * The cache lives in $XDG_RUNTIME_DIR which has to point somewhere
+ * harmless before GLib looks at it for the first time.
+ */
+
+typedef struct test_cache {
+    char* runtime_dir;
+    char* dir;
+    char* file;
+} TestCache;
+
+static
+void
+test_cache_init(
+    TestCache* test)
+{
+    test->runtime_dir = g_dir_make_tmp("test_cache_XXXXXX", NULL);
+    g_assert(test->runtime_dir);
+    g_assert(g_setenv("XDG_RUNTIME_DIR", test->runtime_dir, TRUE));
+    test->dir = g_build_filename(test->runtime_dir, "mce-glib", NULL);
+    test->file = g_build_filename(test->dir, "state", NULL);
+    mce_cache_set_enabled(TRUE);
+}
+
+static
+void
+test_cache_cleanup(
+    TestCache* test)
+{
+    mce_cache_set_enabled(FALSE);
+    g_unlink(test->file);
+    g_rmdir(test->dir);
+    g_rmdir(test->runtime_dir);
+    g_free(test->file);
+    g_free(test->dir);
+    g_free(test->runtime_dir);
+}
+
+static
+void
+test_cache_write(
+    TestCache* test,
+    const char* key,
+    const char* value,
+    gint64 time)
+{
+    GKeyFile* data = g_key_file_new();
+    char* time_key = g_strconcat(key, "-time", NULL);
+
+    g_key_file_set_value(data, "State", key, value);
+    g_key_file_set_int64(data, "State", time_key, time);
+    g_assert(!g_mkdir_with_parents(test->dir, 0700));
+    g_assert(g_key_file_save_to_file(data, test->file, NULL));
+    g_key_file_unref(data);
+    g_free(time_key);
+}
+
+/*==========================================================================*
+ * disabled
+ *==========================================================================*/
+
+static
+void
+test_disabled(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestCache test;
+        int value = -1;
+
+        test_cache_init(&test);
+        test_cache_write(&test, MCE_CACHE_DISPLAY_STATE, "1",
+            g_get_real_time());
+        mce_cache_set_enabled(FALSE);
+        g_assert(!mce_cache_enabled());
+        g_assert(!mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        g_assert(value == -1);
+
+        /* Nothing gets written either */
+        g_unlink(test.file);
+        mce_cache_set(MCE_CACHE_DISPLAY_STATE, MCE_DISPLAY_STATE_ON);
+        mce_cache_flush();
+        g_assert(!g_file_test(test.file, G_FILE_TEST_EXISTS));
+        test_cache_cleanup(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * save
+ *==========================================================================*/
+
+static
+void
+test_save(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestCache test;
+        GKeyFile* data = g_key_file_new();
+        int value = -1;
+
+        test_cache_init(&test);
+        g_assert(mce_cache_enabled());
+        mce_cache_set(MCE_CACHE_DISPLAY_STATE, MCE_DISPLAY_STATE_ON);
+        mce_cache_set(MCE_CACHE_TKLOCK_MODE, MCE_TKLOCK_MODE_UNLOCKED);
+
+        /* The write is delayed until flushed */
+        g_assert(!g_file_test(test.file, G_FILE_TEST_EXISTS));
+        mce_cache_flush();
+        g_assert(g_key_file_load_from_file(data, test.file, 0, NULL));
+        g_assert(g_key_file_get_integer(data, "State",
+            MCE_CACHE_DISPLAY_STATE, NULL) == MCE_DISPLAY_STATE_ON);
+        g_assert(g_key_file_get_integer(data, "State",
+            MCE_CACHE_TKLOCK_MODE, NULL) == MCE_TKLOCK_MODE_UNLOCKED);
+        g_assert(g_key_file_get_int64(data, "State",
+            MCE_CACHE_DISPLAY_STATE "-time", NULL) > 0);
+        g_key_file_unref(data);
+
+        /* And served from memory */
+        g_assert(mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        g_assert(value == MCE_DISPLAY_STATE_ON);
+        test_cache_cleanup(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * reload
+ *==========================================================================*/
+
+static
+void
+test_reload(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestCache test;
+        int value = -1;
+
+        test_cache_init(&test);
+        test_cache_write(&test, MCE_CACHE_TKLOCK_MODE, "6",
+            g_get_real_time());
+        g_assert(mce_cache_get(MCE_CACHE_TKLOCK_MODE,
+            MCE_TKLOCK_MODE_LOCKED, MCE_TKLOCK_MODE_SILENT_UNLOCKED,
+            &value));
+        g_assert(value == MCE_TKLOCK_MODE_SILENT_UNLOCKED);
+        g_assert(!mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        test_cache_cleanup(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * stale
+ *==========================================================================*/
+
+static
+void
+test_stale(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestCache test;
+        int value = -1;
+
+        /* Written long before the boot */
+        test_cache_init(&test);
+        test_cache_write(&test, MCE_CACHE_DISPLAY_STATE, "1", 1);
+        g_assert(!mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        g_assert(value == -1);
+        test_cache_cleanup(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * range
+ *==========================================================================*/
+
+static
+void
+test_range(
+    gconstpointer data)
+{
+    if (g_test_subprocess()) {
+        TestCache test;
+        int value = -1;
+
+        test_cache_init(&test);
+        test_cache_write(&test, MCE_CACHE_DISPLAY_STATE, data,
+            g_get_real_time());
+        g_assert(!mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        g_assert(value == -1);
+
+        /* The bad entry is gone, good ones can be stored again */
+        mce_cache_set(MCE_CACHE_DISPLAY_STATE, MCE_DISPLAY_STATE_OFF);
+        g_assert(mce_cache_get(MCE_CACHE_DISPLAY_STATE,
+            MCE_DISPLAY_STATE_OFF, MCE_DISPLAY_STATE_ON, &value));
+        g_assert(value == MCE_DISPLAY_STATE_OFF);
+        test_cache_cleanup(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/cache/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("disabled"), test_disabled);
+    g_test_add_func(TEST_("save"), test_save);
+    g_test_add_func(TEST_("reload"), test_reload);
+    g_test_add_func(TEST_("stale"), test_stale);
+    g_test_add_data_func(TEST_("range/high"), "2", test_range);
+    g_test_add_data_func(TEST_("range/negative"), "-1", test_range);
+    g_test_add_data_func(TEST_("range/garbage"), "on", test_range);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_call.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+
+#include "com.nokia.mce.request.h"
+
+#include <string.h>
+
+/*
+ * The replay answers right away, these tests need an MCE which can
+ * sit on a request. This one serves get_display_status, holding the
+ * given number of requests unanswered before it starts replying.
+ */
+
+typedef struct test_mce {
+    TestBus bus;
+    guint object_id;
+    guint stall;
+    GPtrArray* stalled;
+} TestMce;
+
+static
+void
+test_mce_call(
+    GDBusConnection* bus,
+    const gchar* sender,
+    const gchar* path,
+    const gchar* iface,
+    const gchar* method,
+    GVariant* args,
+    GDBusMethodInvocation* call,
+    gpointer arg)
+{
+    TestMce* mce = arg;
+
+    if (strcmp(method, "get_display_status")) {
+        g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+            G_DBUS_ERROR_FAILED, "Not implemented %s", method);
+    } else if (mce->stall) {
+        mce->stall--;
+        g_ptr_array_add(mce->stalled, call);
+    } else {
+        g_dbus_method_invocation_return_value(call,
+            g_variant_new("(s)", "on"));
+    }
+}
+
+static const GDBusInterfaceVTable test_mce_vtable = {
+    test_mce_call
+};
+
+static
+void
+test_mce_start(
+    TestMce* mce,
+    guint stall)
+{
+    GError* error = NULL;
+    GVariant* ret;
+    guint reply;
+
+    test_bus_up(&mce->bus);
+    mce->stall = stall;
+    mce->stalled = g_ptr_array_new();
+    mce->object_id = g_dbus_connection_register_object(mce->bus.conn,
+        NOKIA_MCE_REQUEST_PATH, com_nokia_mce_request_interface_info(),
+        &test_mce_vtable, mce, NULL, &error);
+    g_assert_no_error(error);
+    ret = g_dbus_connection_call_sync(mce->bus.conn, "org.freedesktop.DBus",
+        "/org/freedesktop/DBus", "org.freedesktop.DBus", "RequestName",
+        g_variant_new("(su)", NOKIA_MCE_SERVICE, 0), G_VARIANT_TYPE("(u)"),
+        G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+    g_assert_no_error(error);
+    g_variant_get(ret, "(u)", &reply);
+    g_assert_cmpuint(reply, ==, 1); /* DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER */
+    g_variant_unref(ret);
+    mce_bus_set_backend(MCE_BACKEND_NOKIA);
+}
+
+static
+void
+test_mce_stop(
+    TestMce* mce)
+{
+    guint i;
+
+    /* Whoever asked has given up by now */
+    for (i = 0; i < mce->stalled->len; i++) {
+        g_dbus_method_invocation_return_value(mce->stalled->pdata[i],
+            g_variant_new("(s)", "off"));
+    }
+    g_ptr_array_free(mce->stalled, TRUE);
+    g_dbus_connection_unregister_object(mce->bus.conn, mce->object_id);
+    test_bus_down(&mce->bus);
+}
+
+/*==========================================================================*
+ * Display
+ *==========================================================================*/
+
+typedef struct test_display {
+    MceDisplay* display;
+    gulong id;
+    guint calls;
+    gboolean fresh;
+} TestDisplay;
+
+static
+void
+test_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+void
+test_display_fresh_done(
+    MceDisplay* display,
+    gboolean fresh,
+    void* arg)
+{
+    TestDisplay* test = arg;
+
+    test->calls++;
+    test->fresh = fresh;
+    test_check();
+}
+
+static
+gboolean
+test_display_fresh_called(
+    void* arg)
+{
+    TestDisplay* test = arg;
+
+    return test->calls > 0;
+}
+
+static
+gboolean
+test_display_valid(
+    void* arg)
+{
+    TestDisplay* test = arg;
+
+    return test->display->valid;
+}
+
+static
+void
+test_display_new(
+    TestDisplay* test)
+{
+    memset(test, 0, sizeof(*test));
+    test->display = mce_display_new();
+    test->id = mce_display_add_valid_changed_handler(test->display,
+        test_display_changed, NULL);
+}
+
+static
+void
+test_display_get_fresh(
+    TestDisplay* test)
+{
+    test->calls = 0;
+    test->fresh = FALSE;
+    g_assert(!mce_display_get_state_fresh(test->display, 0,
+        test_display_fresh_done, test));
+    test_run_until(test_display_fresh_called, test);
+    g_assert(test->calls == 1);
+}
+
+static
+void
+test_display_free(
+    TestDisplay* test)
+{
+    mce_display_remove_handler(test->display, test->id);
+    mce_display_unref(test->display);
+}
+
+/*==========================================================================*
+ * config
+ *==========================================================================*/
+
+static
+void
+test_config(
+    void)
+{
+    if (g_test_subprocess()) {
+        MceCallStats stats;
+
+        g_assert_cmpint(mce_call_timeout(), ==, MCE_CALL_TIMEOUT_DEFAULT);
+        mce_call_set_timeout(500);
+        g_assert_cmpint(mce_call_timeout(), ==, 500);
+        mce_call_set_timeout(0);
+        g_assert_cmpint(mce_call_timeout(), ==, MCE_CALL_TIMEOUT_DEFAULT);
+
+        /* Hedging is off by default, percentiles don't go beyond 100 */
+        g_assert_cmpuint(mce_call_hedging(), ==, 0);
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.hedge_delay, ==, 0);
+        mce_call_set_hedging(200);
+        g_assert_cmpuint(mce_call_hedging(), ==, 100);
+        mce_call_set_hedging(0);
+        g_assert_cmpuint(mce_call_hedging(), ==, 0);
+
+        /* Nothing has been called yet */
+        g_assert_cmpuint(stats.calls, ==, 0);
+        g_assert_cmpuint(stats.failed, ==, 0);
+        g_assert_cmpuint(stats.samples, ==, 0);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * timeout
+ *==========================================================================*/
+
+#define TEST_TIMEOUT_MS (200)
+
+static
+void
+test_timeout(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestMce mce;
+        TestDisplay test;
+        MceCallStats stats;
+        gint64 start;
+
+        /* MCE never answers */
+        memset(&mce, 0, sizeof(mce));
+        test_mce_start(&mce, G_MAXUINT);
+        mce_call_set_timeout(TEST_TIMEOUT_MS);
+        start = g_get_monotonic_time();
+        test_display_new(&test);
+
+        /* The waiter joins the initial query and learns that it failed */
+        test_display_get_fresh(&test);
+        g_assert(!test.fresh);
+        g_assert(!test.display->valid);
+        g_assert_cmpint(g_get_monotonic_time() - start, >=, 
+            TEST_TIMEOUT_MS * 1000);
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.calls, ==, 0);
+        g_assert_cmpuint(stats.failed, ==, 1);
+        g_assert_cmpuint(stats.samples, ==, 0);
+        g_assert_cmpuint(mce.stalled->len, ==, 1);
+
+        test_display_free(&test);
+        test_mce_stop(&mce);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * hedge
+ *==========================================================================*/
+
+static
+void
+test_hedge(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestMce mce;
+        TestDisplay test;
+        MceCallStats stats;
+
+        /* MCE sits on the first request and answers the hedge one */
+        memset(&mce, 0, sizeof(mce));
+        test_mce_start(&mce, 1);
+        mce_call_set_hedging(50);
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.hedge_delay, >, 0);
+        test_display_new(&test);
+        test_run_until(test_display_valid, &test);
+        g_assert(test.display->state == MCE_DISPLAY_STATE_ON);
+
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.calls, ==, 1);
+        g_assert_cmpuint(stats.failed, ==, 0);
+        g_assert_cmpuint(stats.hedged, ==, 1);
+        g_assert_cmpuint(stats.hedge_won, ==, 1);
+        g_assert_cmpuint(stats.samples, ==, 1);
+        g_assert_cmpuint(mce.stalled->len, ==, 1);
+
+        test_display_free(&test);
+        test_mce_stop(&mce);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * samples
+ *==========================================================================*/
+
+#define TEST_SAMPLES (10)
+
+static
+void
+test_samples(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestMce mce;
+        TestDisplay test;
+        MceCallStats stats;
+        int i;
+
+        /* MCE answers everything right away */
+        memset(&mce, 0, sizeof(mce));
+        test_mce_start(&mce, 0);
+        test_display_new(&test);
+        test_run_until(test_display_valid, &test);
+        for (i = 1; i < TEST_SAMPLES; i++) {
+            g_usleep(1000);
+            test_display_get_fresh(&test);
+            g_assert(test.fresh);
+        }
+
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.calls, ==, TEST_SAMPLES);
+        g_assert_cmpuint(stats.failed, ==, 0);
+        g_assert_cmpuint(stats.samples, ==, TEST_SAMPLES);
+        g_assert_cmpuint(stats.latency_min, <=, stats.latency_p50);
+        g_assert_cmpuint(stats.latency_p50, <=, stats.latency_p90);
+        g_assert_cmpuint(stats.latency_p90, <=, stats.latency_max);
+        g_assert_cmpuint(stats.latency_p90, ==, 
+            mce_call_latency_percentile(90));
+
+        /* With enough samples the hedge delay follows the percentile */
+        mce_call_set_hedging(90);
+        mce_call_get_stats(&stats);
+        g_assert_cmpuint(stats.hedge_delay, ==, 
+            MAX(stats.latency_p90, 1000));
+
+        test_display_free(&test);
+        test_mce_stop(&mce);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/call/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("config"), test_config);
+    g_test_add_func(TEST_("timeout"), test_timeout);
+    g_test_add_func(TEST_("hedge"), test_hedge);
+    g_test_add_func(TEST_("samples"), test_samples);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
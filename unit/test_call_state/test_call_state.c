@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_call_state.h"
+#include "mce_inactivity.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+
+#include <string.h>
+
+typedef struct test_call {
+    TestProvider provider;
+    MceCallState* call;
+    MceInactivity* inactivity;
+    gulong call_id[3];
+    gulong inactivity_id[2];
+    guint state_changes;
+    MCE_CALL_TYPE type_seen;
+} TestCall;
+
+static
+void
+test_changed(
+    gpointer object,
+    void* arg)
+{
+    test_check();
+}
+
+static
+void
+test_call_state_changed(
+    MceCallState* call,
+    void* arg)
+{
+    TestCall* test = arg;
+
+    /* Both fields are updated before anything is emitted */
+    test->state_changes++;
+    test->type_seen = call->type;
+    test_check();
+}
+
+static
+GByteArray*
+test_call_record(
+    const char* state,
+    const char* type,
+    gboolean inactive)
+{
+    GByteArray* rec = test_record_new();
+
+    test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+        (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+        "get_call_state", g_variant_new("(ss)", state, type)));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+        "get_inactivity_status", g_variant_new("(b)", inactive)));
+    return rec;
+}
+
+static
+gboolean
+test_valid(
+    void* arg)
+{
+    TestCall* test = arg;
+
+    return test->call->valid && test->inactivity->valid;
+}
+
+static
+gboolean
+test_invalid(
+    void* arg)
+{
+    TestCall* test = arg;
+
+    return !test->call->valid && !test->inactivity->valid;
+}
+
+static
+gboolean
+test_call_active(
+    void* arg)
+{
+    TestCall* test = arg;
+
+    return test->call->state == MCE_CALL_STATE_ACTIVE;
+}
+
+static
+gboolean
+test_active(
+    void* arg)
+{
+    TestCall* test = arg;
+
+    return !test->inactivity->status;
+}
+
+/*==========================================================================*
+ * sync
+ *==========================================================================*/
+
+static
+void
+test_sync(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestCall test;
+
+        memset(&test, 0, sizeof(test));
+        test_provider_start(&test.provider,
+            test_call_record("ringing", "normal", TRUE));
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        test.call = mce_call_state_new();
+        test.inactivity = mce_inactivity_new();
+        test.call_id[0] = mce_call_state_add_valid_changed_handler
+            (test.call, (MceCallStateFunc)test_changed, NULL);
+        test.call_id[1] = mce_call_state_add_state_changed_handler
+            (test.call, test_call_state_changed, &test);
+        test.call_id[2] = mce_call_state_add_type_changed_handler
+            (test.call, (MceCallStateFunc)test_changed, NULL);
+        test.inactivity_id[0] = mce_inactivity_add_valid_changed_handler
+            (test.inactivity, (MceInactivityFunc)test_changed, NULL);
+        test.inactivity_id[1] = mce_inactivity_add_status_changed_handler
+            (test.inactivity, (MceInactivityFunc)test_changed, NULL);
+
+        /* Initial query */
+        test_run_until(test_valid, &test);
+        g_assert(test.call->state == MCE_CALL_STATE_RINGING);
+        g_assert(test.call->type == MCE_CALL_TYPE_NORMAL);
+        g_assert(test.inactivity->status);
+
+        /* Changes announced by mce */
+        test.state_changes = 0;
+        test_provider_emit(&test.provider, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "sig_call_state_ind",
+            g_variant_new("(ss)", "active", "emergency"));
+        test_run_until(test_call_active, &test);
+        g_assert_cmpuint(test.state_changes, ==, 1);
+        g_assert(test.type_seen == MCE_CALL_TYPE_EMERGENCY);
+        test_provider_emit(&test.provider, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "system_inactivity_ind",
+            g_variant_new("(b)", FALSE));
+        test_run_until(test_active, &test);
+
+        /* mce restarts in a different state, both get back in sync */
+        test_provider_stop(&test.provider);
+        test_run_until(test_invalid, &test);
+        test_provider_start(&test.provider,
+            test_call_record("none", "normal", TRUE));
+        test_run_until(test_valid, &test);
+        g_assert(test.call->state == MCE_CALL_STATE_NONE);
+        g_assert(test.call->type == MCE_CALL_TYPE_NORMAL);
+        g_assert(test.inactivity->status);
+
+        mce_call_state_remove_all_handlers(test.call, test.call_id);
+        mce_inactivity_remove_all_handlers(test.inactivity,
+            test.inactivity_id);
+        mce_call_state_unref(test.call);
+        mce_inactivity_unref(test.inactivity);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/call_state/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("sync"), test_sync);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
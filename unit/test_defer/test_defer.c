@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+#include "mce_tklock.h"
+
+#include <string.h>
+
+/*
+ * Native mce with the display off and tklock locked. The tests
+ * then drive both of them with signals.
+ */
+
+typedef struct test_defer {
+    TestProvider provider;
+    MceDisplay* display;
+    MceTklock* tklock;
+    gulong display_id[2];
+    gulong tklock_id[2];
+    guint display_calls;
+    guint tklock_calls;
+    MCE_TKLOCK_MODE tklock_mode; /* Seen by the deferred handler */
+    MCE_TKLOCK_MODE tklock_wait;
+} TestDefer;
+
+static
+void
+test_changed(
+    gpointer object,
+    void* arg)
+{
+    test_check();
+}
+
+static
+void
+test_deferred_display(
+    MceDisplay* display,
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    test->display_calls++;
+    test_check();
+}
+
+static
+void
+test_deferred_tklock(
+    MceTklock* tklock,
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    test->tklock_calls++;
+    test->tklock_mode = tklock->mode;
+    test_check();
+}
+
+static
+gboolean
+test_valid(
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    return test->display->valid && test->tklock->valid;
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    return test->display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_tklock_mode(
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    return test->tklock->mode == test->tklock_wait;
+}
+
+static
+void
+test_defer_start(
+    TestDefer* test)
+{
+    GByteArray* rec = test_record_new();
+
+    memset(test, 0, sizeof(*test));
+    test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+        (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+        "get_display_status", g_variant_new("(s)", "off")));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+        "get_tklock_mode", g_variant_new("(s)", "locked")));
+    test_provider_start(&test->provider, rec);
+    mce_bus_set_backend(MCE_BACKEND_NOKIA);
+
+    test->display = mce_display_new();
+    test->tklock = mce_tklock_new();
+    test->display_id[0] = mce_display_add_valid_changed_handler
+        (test->display, (MceDisplayFunc)test_changed, NULL);
+    test->display_id[1] = mce_display_add_state_changed_handler
+        (test->display, (MceDisplayFunc)test_changed, NULL);
+    test->tklock_id[0] = mce_tklock_add_valid_changed_handler
+        (test->tklock, (MceTklockFunc)test_changed, NULL);
+    test->tklock_id[1] = mce_tklock_add_mode_changed_handler
+        (test->tklock, (MceTklockFunc)test_changed, NULL);
+    test_run_until(test_valid, test);
+    g_assert(test->display->state == MCE_DISPLAY_STATE_OFF);
+}
+
+static
+void
+test_defer_tklock(
+    TestDefer* test,
+    const char* mode,
+    MCE_TKLOCK_MODE value)
+{
+    test_provider_emit(&test->provider, NOKIA_MCE_SIGNAL_PATH,
+        NOKIA_MCE_SIGNAL_INTERFACE, "tklock_mode_ind",
+        g_variant_new("(s)", mode));
+    test->tklock_wait = value;
+    test_run_until(test_tklock_mode, test);
+}
+
+static
+void
+test_defer_stop(
+    TestDefer* test)
+{
+    mce_display_remove_all_handlers(test->display, test->display_id);
+    mce_tklock_remove_all_handlers(test->tklock, test->tklock_id);
+    mce_display_unref(test->display);
+    mce_tklock_unref(test->tklock);
+    test_provider_stop(&test->provider);
+}
+
+/*==========================================================================*
+ * collapse
+ *==========================================================================*/
+
+static
+void
+test_collapse(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestDefer test;
+        gulong tklock_id, display_id;
+
+        test_defer_start(&test);
+        tklock_id = mce_tklock_add_mode_changed_handler_full(test.tklock,
+            MCE_PRIORITY_DEFERRABLE, test_deferred_tklock, &test);
+        display_id = mce_display_add_state_changed_handler_full
+            (test.display, MCE_PRIORITY_DEFERRABLE, test_deferred_display,
+            &test);
+
+        /* Nothing gets through while the display is off */
+        test_defer_tklock(&test, "unlocked", MCE_TKLOCK_MODE_UNLOCKED);
+        test_defer_tklock(&test, "locked-dim", MCE_TKLOCK_MODE_LOCKED_DIM);
+        test_defer_tklock(&test, "silent-unlocked",
+            MCE_TKLOCK_MODE_SILENT_UNLOCKED);
+        g_assert(!test.tklock_calls);
+        g_assert(!test.display_calls);
+
+        /* Turning the display on flushes one call with the latest mode */
+        test_provider_emit(&test.provider, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+            g_variant_new("(s)", "on"));
+        test_run_until(test_display_on, &test);
+        g_assert_cmpuint(test.tklock_calls, ==, 1);
+        g_assert(test.tklock_mode == MCE_TKLOCK_MODE_SILENT_UNLOCKED);
+        g_assert_cmpuint(test.display_calls, ==, 1);
+
+        /* With the display on, the handlers are invoked right away */
+        test_defer_tklock(&test, "locked", MCE_TKLOCK_MODE_LOCKED);
+        g_assert_cmpuint(test.tklock_calls, ==, 2);
+        g_assert(test.tklock_mode == MCE_TKLOCK_MODE_LOCKED);
+
+        mce_tklock_remove_handler(test.tklock, tklock_id);
+        mce_display_remove_handler(test.display, display_id);
+        test_defer_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * lost
+ *==========================================================================*/
+
+static
+gboolean
+test_tklock_called(
+    void* arg)
+{
+    TestDefer* test = arg;
+
+    return test->tklock_calls > 0;
+}
+
+static
+void
+test_lost(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestDefer test;
+        gulong tklock_id;
+
+        test_defer_start(&test);
+        tklock_id = mce_tklock_add_mode_changed_handler_full(test.tklock,
+            MCE_PRIORITY_DEFERRABLE, test_deferred_tklock, &test);
+        test_defer_tklock(&test, "unlocked", MCE_TKLOCK_MODE_UNLOCKED);
+        g_assert(!test.tklock_calls);
+
+        /* The display state is no longer known, the handler runs */
+        test_provider_stop(&test.provider);
+        test_run_until(test_tklock_called, &test);
+        g_assert_cmpuint(test.tklock_calls, ==, 1);
+        g_assert(test.tklock_mode == MCE_TKLOCK_MODE_UNLOCKED);
+
+        mce_tklock_remove_handler(test.tklock, tklock_id);
+        mce_display_remove_all_handlers(test.display, test.display_id);
+        mce_tklock_remove_all_handlers(test.tklock, test.tklock_id);
+        mce_display_unref(test.display);
+        mce_tklock_unref(test.tklock);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/defer/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("collapse"), test_collapse);
+    g_test_add_func(TEST_("lost"), test_lost);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
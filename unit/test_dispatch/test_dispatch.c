@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+
+#include <string.h>
+
+/*
+ * Display handlers registered from a thread with a context of its own.
+ * The thread connects its handler, then waits for the go-ahead before
+ * running its loop, which lets the main thread decide what happens to
+ * the display in the meantime.
+ */
+
+typedef struct test_worker {
+    GThread* thread;
+    GMainContext* context;
+    GMainLoop* loop;
+    MceDisplay* display;
+    GMutex mutex;
+    GCond cond;
+    gboolean connected;
+    gboolean go;
+    gboolean block;
+    gboolean entered;
+    gboolean release;
+    guint calls;
+    GThread* called_on;
+} TestWorker;
+
+typedef struct test_dispatch {
+    TestProvider provider;
+    MceDisplay* display;
+    GThread* main_thread;
+    GThread* finalized_on;
+    gboolean finalized;
+} TestDispatch;
+
+static
+void
+test_worker_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    TestWorker* worker = arg;
+
+    worker->calls++;
+    worker->called_on = g_thread_self();
+    if (worker->block) {
+        /* Hold on to the display until the main thread lets go of it */
+        g_mutex_lock(&worker->mutex);
+        worker->entered = TRUE;
+        g_cond_broadcast(&worker->cond);
+        while (!worker->release) {
+            g_cond_wait(&worker->cond, &worker->mutex);
+        }
+        g_mutex_unlock(&worker->mutex);
+    }
+    g_main_loop_quit(worker->loop);
+}
+
+static
+gboolean
+test_worker_quit(
+    gpointer arg)
+{
+    TestWorker* worker = arg;
+
+    g_main_loop_quit(worker->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gpointer
+test_worker_thread(
+    gpointer arg)
+{
+    TestWorker* worker = arg;
+
+    g_main_context_push_thread_default(worker->context);
+    mce_display_add_state_changed_handler(worker->display,
+        test_worker_changed, worker);
+    g_mutex_lock(&worker->mutex);
+    worker->connected = TRUE;
+    g_cond_broadcast(&worker->cond);
+    while (!worker->go) {
+        g_cond_wait(&worker->cond, &worker->mutex);
+    }
+    g_mutex_unlock(&worker->mutex);
+    g_main_loop_run(worker->loop);
+    g_main_context_pop_thread_default(worker->context);
+    return NULL;
+}
+
+static
+void
+test_worker_start(
+    TestWorker* worker,
+    MceDisplay* display)
+{
+    memset(worker, 0, sizeof(*worker));
+    g_mutex_init(&worker->mutex);
+    g_cond_init(&worker->cond);
+    worker->display = display;
+    worker->context = g_main_context_new();
+    worker->loop = g_main_loop_new(worker->context, FALSE);
+    worker->thread = g_thread_new("worker", test_worker_thread, worker);
+    g_mutex_lock(&worker->mutex);
+    while (!worker->connected) {
+        g_cond_wait(&worker->cond, &worker->mutex);
+    }
+    g_mutex_unlock(&worker->mutex);
+}
+
+static
+void
+test_worker_go(
+    TestWorker* worker)
+{
+    g_mutex_lock(&worker->mutex);
+    worker->go = TRUE;
+    g_cond_broadcast(&worker->cond);
+    g_mutex_unlock(&worker->mutex);
+}
+
+static
+void
+test_worker_join(
+    TestWorker* worker)
+{
+    g_thread_join(worker->thread);
+    g_main_loop_unref(worker->loop);
+    g_main_context_unref(worker->context);
+    g_cond_clear(&worker->cond);
+    g_mutex_clear(&worker->mutex);
+}
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    TestDispatch* test = arg;
+
+    return test->display->valid &&
+        test->display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    TestDispatch* test = arg;
+
+    return test->display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+gboolean
+test_display_finalized(
+    void* arg)
+{
+    TestDispatch* test = arg;
+
+    return test->finalized;
+}
+
+static
+void
+test_display_weak_notify(
+    gpointer arg,
+    GObject* object)
+{
+    TestDispatch* test = arg;
+
+    test->finalized = TRUE;
+    test->finalized_on = g_thread_self();
+    test_check();
+}
+
+static
+gulong
+test_dispatch_start(
+    TestDispatch* test)
+{
+    gulong id;
+
+    memset(test, 0, sizeof(*test));
+    test->main_thread = g_thread_self();
+    test_provider_start(&test->provider, test_record_unity(TRUE));
+    mce_bus_set_backend(MCE_BACKEND_UNITY);
+    test->display = mce_display_new();
+    id = mce_display_add_state_changed_handler(test->display,
+        test_changed, NULL);
+    test_run_until(test_display_on, test);
+    return id;
+}
+
+static
+void
+test_dispatch_turn_off(
+    TestDispatch* test)
+{
+    test_provider_emit(&test->provider, MCE_SIGNAL_PATH, MCE_INTERFACE,
+        "DisplayPowerStateChange", g_variant_new("(ii)", 0, 0));
+    test_run_until(test_display_off, test);
+}
+
+/*==========================================================================*
+ * thread
+ *==========================================================================*/
+
+static
+void
+test_thread(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestDispatch test;
+        TestWorker worker;
+        gulong id = test_dispatch_start(&test);
+
+        test_worker_start(&worker, test.display);
+        test_worker_go(&worker);
+        test_dispatch_turn_off(&test);
+        test_worker_join(&worker);
+
+        /* Delivered once, to the thread which registered the handler */
+        g_assert(worker.calls == 1);
+        g_assert(worker.called_on == worker.thread);
+
+        mce_display_remove_handler(test.display, id);
+        mce_display_unref(test.display);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * release
+ *==========================================================================*/
+
+static
+void
+test_release(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestDispatch test;
+        TestWorker worker;
+        gulong id = test_dispatch_start(&test);
+
+        test_worker_start(&worker, test.display);
+        worker.block = TRUE;
+        test_worker_go(&worker);
+        test_dispatch_turn_off(&test);
+
+        /* The worker is in the handler, drop our reference */
+        g_mutex_lock(&worker.mutex);
+        while (!worker.entered) {
+            g_cond_wait(&worker.cond, &worker.mutex);
+        }
+        g_mutex_unlock(&worker.mutex);
+        g_object_weak_ref(G_OBJECT(test.display), test_display_weak_notify,
+            &test);
+        mce_display_remove_handler(test.display, id);
+        mce_display_unref(test.display);
+        g_assert(!test.finalized);
+
+        /* The last reference comes back to the main thread */
+        g_mutex_lock(&worker.mutex);
+        worker.release = TRUE;
+        g_cond_broadcast(&worker.cond);
+        g_mutex_unlock(&worker.mutex);
+        test_run_until(test_display_finalized, &test);
+        g_assert(test.finalized_on == test.main_thread);
+
+        test_worker_join(&worker);
+        g_assert(worker.calls == 1);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * gone
+ *==========================================================================*/
+
+static
+void
+test_gone(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestDispatch test;
+        TestWorker worker;
+        gulong id = test_dispatch_start(&test);
+
+        /* The notification is pending when the display goes away */
+        test_worker_start(&worker, test.display);
+        test_dispatch_turn_off(&test);
+        g_object_weak_ref(G_OBJECT(test.display), test_display_weak_notify,
+            &test);
+        mce_display_remove_handler(test.display, id);
+        mce_display_unref(test.display);
+        g_assert(test.finalized);
+        g_assert(test.finalized_on == test.main_thread);
+
+        /* And doesn't get delivered */
+        g_main_context_invoke_full(worker.context, G_PRIORITY_LOW,
+            test_worker_quit, &worker, NULL);
+        test_worker_go(&worker);
+        test_worker_join(&worker);
+        g_assert(!worker.calls);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/dispatch/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("thread"), test_thread);
+    g_test_add_func(TEST_("release"), test_release);
+    g_test_add_func(TEST_("gone"), test_gone);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
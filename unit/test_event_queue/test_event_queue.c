@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_event_queue.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+
+#include <poll.h>
+#include <string.h>
+
+/*
+ * Native mce with the display off. Further display changes are
+ * emitted by the tests themselves, one at a time.
+ */
+
+typedef struct test_queue {
+    TestProvider provider;
+    MceDisplay* display;
+    gulong id[2];
+} TestQueue;
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_display_valid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid;
+}
+
+static
+gboolean
+test_display_invalid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return !display->valid;
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+test_queue_start(
+    TestQueue* test)
+{
+    GByteArray* rec = test_record_new();
+
+    memset(test, 0, sizeof(*test));
+    test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+        (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+    test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+        (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+        "get_display_status", g_variant_new("(s)", "off")));
+    test_provider_start(&test->provider, rec);
+    mce_bus_set_backend(MCE_BACKEND_NOKIA);
+    test->display = mce_display_new();
+    test->id[0] = mce_display_add_valid_changed_handler(test->display,
+        test_changed, NULL);
+    test->id[1] = mce_display_add_state_changed_handler(test->display,
+        test_changed, NULL);
+    test_run_until(test_display_valid, test->display);
+}
+
+static
+void
+test_queue_display(
+    TestQueue* test,
+    MCE_DISPLAY_STATE state)
+{
+    const gboolean on = (state == MCE_DISPLAY_STATE_ON);
+
+    test_provider_emit(&test->provider, NOKIA_MCE_SIGNAL_PATH,
+        NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+        g_variant_new("(s)", on ? "on" : "off"));
+    test_run_until(on ? test_display_on : test_display_off, test->display);
+}
+
+static
+void
+test_queue_stop(
+    TestQueue* test)
+{
+    mce_display_remove_all_handlers(test->display, test->id);
+    mce_display_unref(test->display);
+    test_provider_stop(&test->provider);
+}
+
+static
+gboolean
+test_readable(
+    int fd)
+{
+    struct pollfd pfd;
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+/*==========================================================================*
+ * keep_latest
+ *==========================================================================*/
+
+static
+void
+test_keep_latest(
+    void)
+{
+    if (g_test_subprocess()) {
+        MceEventQueue* queue = mce_event_queue_new(1,
+            MCE_EVENT_QUEUE_KEEP_LATEST);
+        MceEvent events[2];
+        TestQueue test;
+
+        /* Grows to fit both kinds of display events */
+        test_queue_start(&test);
+        g_assert(mce_event_queue_add(queue, test.display));
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+        test_queue_display(&test, MCE_DISPLAY_STATE_OFF);
+        g_assert_cmpuint(mce_event_queue_dropped(queue), ==, 0);
+
+        /* The oldest state gives way to the newest */
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+        g_assert_cmpuint(mce_event_queue_dropped(queue), ==, 1);
+
+        /*
+         * The valid flag isn't in the queue, the older one of the two
+         * states makes room for it.
+         */
+        test_provider_stop(&test.provider);
+        test_run_until(test_display_invalid, test.display);
+        g_assert_cmpuint(mce_event_queue_dropped(queue), ==, 2);
+
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events,
+            G_N_ELEMENTS(events)), ==, 2);
+        g_assert(events[0].object == test.display);
+        g_assert(events[0].type == MCE_EVENT_DISPLAY_STATE);
+        g_assert(events[0].value == MCE_DISPLAY_STATE_ON);
+        g_assert(events[0].reason == MCE_EVENT_REASON_CHANGE);
+        g_assert(events[1].object == test.display);
+        g_assert(events[1].type == MCE_EVENT_VALID);
+        g_assert(!events[1].value);
+        g_assert(events[1].reason == MCE_EVENT_REASON_LOST);
+
+        mce_event_queue_free(queue);
+        mce_display_remove_all_handlers(test.display, test.id);
+        mce_display_unref(test.display);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * drop_oldest
+ *==========================================================================*/
+
+static
+void
+test_drop_oldest(
+    void)
+{
+    if (g_test_subprocess()) {
+        MceEventQueue* queue = mce_event_queue_new(2,
+            MCE_EVENT_QUEUE_DROP_OLDEST);
+        MceEvent events[2];
+        TestQueue test;
+
+        test_queue_start(&test);
+        g_assert(mce_event_queue_add(queue, test.display));
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+        test_queue_display(&test, MCE_DISPLAY_STATE_OFF);
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+        g_assert_cmpuint(mce_event_queue_dropped(queue), ==, 1);
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events,
+            G_N_ELEMENTS(events)), ==, 2);
+        g_assert(events[0].value == MCE_DISPLAY_STATE_OFF);
+        g_assert(events[1].value == MCE_DISPLAY_STATE_ON);
+
+        mce_event_queue_free(queue);
+        test_queue_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * partial
+ *==========================================================================*/
+
+static
+void
+test_partial(
+    void)
+{
+    if (g_test_subprocess()) {
+        MceEventQueue* queue = mce_event_queue_new(0,
+            MCE_EVENT_QUEUE_DROP_OLDEST);
+        const int fd = mce_event_queue_fd(queue);
+        MceEvent events[3];
+        TestQueue test;
+
+        test_queue_start(&test);
+        g_assert(mce_event_queue_add(queue, test.display));
+        g_assert(!test_readable(fd));
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+        test_queue_display(&test, MCE_DISPLAY_STATE_OFF);
+        test_queue_display(&test, MCE_DISPLAY_STATE_ON);
+
+        /* Stays readable until the queue is empty */
+        g_assert(test_readable(fd));
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events, 1), ==, 1);
+        g_assert(events[0].value == MCE_DISPLAY_STATE_ON);
+        g_assert(test_readable(fd));
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events, 1), ==, 1);
+        g_assert(events[0].value == MCE_DISPLAY_STATE_OFF);
+        g_assert(test_readable(fd));
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events,
+            G_N_ELEMENTS(events)), ==, 1);
+        g_assert(events[0].value == MCE_DISPLAY_STATE_ON);
+        g_assert(!test_readable(fd));
+        g_assert_cmpuint(mce_event_queue_pop_batch(queue, events,
+            G_N_ELEMENTS(events)), ==, 0);
+
+        /* And becomes readable again with the next event */
+        test_queue_display(&test, MCE_DISPLAY_STATE_OFF);
+        g_assert(test_readable(fd));
+
+        mce_event_queue_free(queue);
+        test_queue_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * thread
+ *==========================================================================*/
+
+#define TEST_THREAD_EVENTS (20)
+
+typedef struct test_consumer {
+    MceEventQueue* queue;
+    int values[TEST_THREAD_EVENTS];
+    guint count;
+} TestConsumer;
+
+static
+gpointer
+test_consumer_thread(
+    gpointer data)
+{
+    TestConsumer* consumer = data;
+    struct pollfd pfd;
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = mce_event_queue_fd(consumer->queue);
+    pfd.events = POLLIN;
+    while (consumer->count < TEST_THREAD_EVENTS) {
+        MceEvent events[4];
+        guint i, n;
+
+        g_assert(poll(&pfd, 1, TEST_TIMEOUT_SEC * 1000) == 1);
+        n = mce_event_queue_pop_batch(consumer->queue, events,
+            G_N_ELEMENTS(events));
+        for (i = 0; i < n && consumer->count < TEST_THREAD_EVENTS; i++) {
+            consumer->values[consumer->count++] = events[i].value;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+test_thread(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestConsumer consumer;
+        GThread* thread;
+        TestQueue test;
+        guint i;
+
+        memset(&consumer, 0, sizeof(consumer));
+        consumer.queue = mce_event_queue_new(TEST_THREAD_EVENTS,
+            MCE_EVENT_QUEUE_DROP_OLDEST);
+        test_queue_start(&test);
+        g_assert(mce_event_queue_add(consumer.queue, test.display));
+        thread = g_thread_new("consumer", test_consumer_thread, &consumer);
+
+        /* The consumer sees every change, in order */
+        for (i = 0; i < TEST_THREAD_EVENTS; i++) {
+            test_queue_display(&test, (i % 2) ? MCE_DISPLAY_STATE_OFF :
+                MCE_DISPLAY_STATE_ON);
+        }
+        g_thread_join(thread);
+        g_assert_cmpuint(mce_event_queue_dropped(consumer.queue), ==, 0);
+        for (i = 0; i < TEST_THREAD_EVENTS; i++) {
+            g_assert(consumer.values[i] == ((i % 2) ?
+                MCE_DISPLAY_STATE_OFF : MCE_DISPLAY_STATE_ON));
+        }
+
+        mce_event_queue_free(consumer.queue);
+        test_queue_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/event_queue/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("keep_latest"), test_keep_latest);
+    g_test_add_func(TEST_("drop_oldest"), test_drop_oldest);
+    g_test_add_func(TEST_("partial"), test_partial);
+    g_test_add_func(TEST_("thread"), test_thread);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+
+#include <string.h>
+
+#define TEST_INTERVAL_MS (10)
+#define TEST_IDLE_MS (100)
+
+typedef struct test_gated {
+    TestProvider provider;
+    MceDisplay* display;
+    gulong id[2];
+    guint calls;
+    guint wait;
+} TestGated;
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_gated_tick(
+    gpointer arg)
+{
+    TestGated* test = arg;
+
+    test->calls++;
+    test_check();
+    return G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+test_gated_called(
+    void* arg)
+{
+    TestGated* test = arg;
+
+    return test->calls >= test->wait;
+}
+
+static
+gboolean
+test_display_valid(
+    void* arg)
+{
+    TestGated* test = arg;
+
+    return test->display->valid;
+}
+
+static
+gboolean
+test_display_invalid(
+    void* arg)
+{
+    TestGated* test = arg;
+
+    return !test->display->valid;
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    TestGated* test = arg;
+
+    return test->display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    TestGated* test = arg;
+
+    return test->display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+gboolean
+test_timeout_done(
+    gpointer arg)
+{
+    *((gboolean*)arg) = TRUE;
+    test_check();
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_flag(
+    void* arg)
+{
+    return *((gboolean*)arg);
+}
+
+static
+void
+test_run_ms(
+    guint ms)
+{
+    gboolean done = FALSE;
+
+    g_timeout_add(ms, test_timeout_done, &done);
+    test_run_until(test_flag, &done);
+}
+
+static
+void
+test_gated_display(
+    TestGated* test,
+    gboolean on)
+{
+    test_provider_emit(&test->provider, NOKIA_MCE_SIGNAL_PATH,
+        NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+        g_variant_new("(s)", on ? "on" : "off"));
+    test_run_until(on ? test_display_on : test_display_off, test);
+}
+
+/*==========================================================================*
+ * gate
+ *==========================================================================*/
+
+static
+void
+test_gate(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestGated test;
+        GSource* source;
+        guint calls;
+
+        /* Native mce with the display off */
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_display_status", g_variant_new("(s)", "off")));
+        test_provider_start(&test.provider, rec);
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        test.display = mce_display_new();
+        test.id[0] = mce_display_add_valid_changed_handler(test.display,
+            test_changed, NULL);
+        test.id[1] = mce_display_add_state_changed_handler(test.display,
+            test_changed, NULL);
+        test_run_until(test_display_valid, &test);
+
+        source = mce_display_gated_source_new(test.display,
+            MCE_DISPLAY_STATE_ON, TEST_INTERVAL_MS);
+        g_source_set_callback(source, test_gated_tick, &test, NULL);
+        g_source_attach(source, NULL);
+
+        /* Gated off while the display is off */
+        test_run_ms(TEST_IDLE_MS);
+        g_assert_cmpuint(test.calls, ==, 0);
+
+        /* The overdue tick fires as soon as it opens, then repeats */
+        test_gated_display(&test, TRUE);
+        test.wait = 3;
+        test_run_until(test_gated_called, &test);
+
+        /* And stops again */
+        test_gated_display(&test, FALSE);
+        calls = test.calls;
+        test_run_ms(TEST_IDLE_MS);
+        g_assert_cmpuint(test.calls, ==, calls);
+
+        /* Unknown state is not the requested one either */
+        test_gated_display(&test, TRUE);
+        test.wait = calls + 1;
+        test_run_until(test_gated_called, &test);
+        test_provider_stop(&test.provider);
+        test_run_until(test_display_invalid, &test);
+        calls = test.calls;
+        test_run_ms(TEST_IDLE_MS);
+        g_assert_cmpuint(test.calls, ==, calls);
+
+        g_source_destroy(source);
+        g_source_unref(source);
+        mce_display_remove_all_handlers(test.display, test.id);
+        mce_display_unref(test.display);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/gated_source/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("gate"), test_gate);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
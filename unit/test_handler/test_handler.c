@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+
+#include <string.h>
+
+#define TEST_BUDGET_US (10000)
+#define TEST_SLOW_US (3 * TEST_BUDGET_US)
+
+typedef struct test_handler {
+    TestProvider provider;
+    MceDisplay* display;
+    gulong valid_id;
+    gulong state_id;
+} TestHandler;
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+void
+test_slow(
+    MceDisplay* display,
+    void* arg)
+{
+    g_usleep(TEST_SLOW_US);
+    test_check();
+}
+
+static
+gboolean
+test_display_valid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid;
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+test_handler_display(
+    TestHandler* test,
+    gboolean on)
+{
+    test_provider_emit(&test->provider, NOKIA_MCE_SIGNAL_PATH,
+        NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+        g_variant_new("(s)", on ? "on" : "off"));
+    test_run_until(on ? test_display_on : test_display_off,
+        test->display);
+}
+
+/*==========================================================================*
+ * budget
+ *==========================================================================*/
+
+static
+void
+test_budget(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        MceHandlerStats stats;
+        TestHandler test;
+
+        /* Native mce with the display off */
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_display_status", g_variant_new("(s)", "off")));
+        test_provider_start(&test.provider, rec);
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        test.display = mce_display_new();
+        test.valid_id = mce_display_add_valid_changed_handler(test.display,
+            test_changed, NULL);
+        test_run_until(test_display_valid, test.display);
+
+        mce_handler_set_budget(TEST_BUDGET_US);
+        g_assert_cmpuint(mce_handler_budget(), ==, TEST_BUDGET_US);
+        test.state_id = mce_display_add_state_changed_handler(test.display,
+            test_slow, &test);
+
+        /* Over the budget, warned about */
+        test_handler_display(&test, TRUE);
+        g_assert(test_handler_stats(G_CALLBACK(test_slow), &test, &stats));
+        g_assert_cmpuint(stats.calls, ==, 1);
+        g_assert_cmpuint(stats.slow, ==, 1);
+        g_assert_cmpuint(stats.max, >=, TEST_SLOW_US);
+
+        /* Still counted, but the warning is rate limited */
+        test_handler_display(&test, FALSE);
+        g_assert(test_handler_stats(G_CALLBACK(test_slow), &test, &stats));
+        g_assert_cmpuint(stats.calls, ==, 2);
+        g_assert_cmpuint(stats.slow, ==, 2);
+
+        /* Zero budget means no budget */
+        mce_handler_set_budget(0);
+        test_handler_display(&test, TRUE);
+        g_assert(test_handler_stats(G_CALLBACK(test_slow), &test, &stats));
+        g_assert_cmpuint(stats.calls, ==, 3);
+        g_assert_cmpuint(stats.slow, ==, 2);
+
+        /* The stats can be reset */
+        mce_handler_reset_stats();
+        g_assert(test_handler_stats(G_CALLBACK(test_slow), &test, &stats));
+        g_assert_cmpuint(stats.calls, ==, 0);
+        g_assert_cmpuint(stats.slow, ==, 0);
+
+        mce_display_remove_handler(test.display, test.valid_id);
+        mce_display_remove_handler(test.display, test.state_id);
+        g_assert(!test_handler_stats(G_CALLBACK(test_slow), &test, &stats));
+        mce_display_unref(test.display);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+    g_test_trap_assert_stdout("*of mce-display-state-changed took * ms "
+        "(budget 10 ms)*");
+    g_test_trap_assert_stdout_unmatched("*more times*");
+}
+
+#define TEST_(name) "/handler/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("budget"), test_budget);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_linger.h"
+
+#include <string.h>
+
+static
+gboolean
+test_display_valid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid;
+}
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+void
+test_finalized(
+    gpointer data,
+    GObject* object)
+{
+    *((gboolean*)data) = TRUE;
+    test_check();
+}
+
+static
+gboolean
+test_flag(
+    void* arg)
+{
+    return *((gboolean*)arg);
+}
+
+static
+MceDisplay*
+test_display_new(
+    gboolean* finalized)
+{
+    MceDisplay* display = mce_display_new();
+    const gulong id = mce_display_add_valid_changed_handler(display,
+        test_changed, NULL);
+
+    test_run_until(test_display_valid, display);
+    mce_display_remove_handler(display, id);
+    *finalized = FALSE;
+    g_object_weak_ref(G_OBJECT(display), test_finalized, finalized);
+    return display;
+}
+
+/*==========================================================================*
+ * revive
+ *==========================================================================*/
+
+static
+void
+test_revive(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestProvider provider;
+        MceDisplay* display;
+        gboolean finalized;
+
+        memset(&provider, 0, sizeof(provider));
+        test_provider_start(&provider, test_record_unity(TRUE));
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        mce_linger_set_time(TEST_TIMEOUT_SEC * 1000);
+        g_assert_cmpuint(mce_linger_time(), ==, TEST_TIMEOUT_SEC * 1000);
+        display = test_display_new(&finalized);
+
+        /* Released but kept around, and comes back still valid */
+        mce_display_unref(display);
+        g_assert(!finalized);
+        g_assert(mce_display_new() == display);
+        g_assert(display->valid);
+        g_assert(display->state == MCE_DISPLAY_STATE_ON);
+
+        /* Reviving again works the same way */
+        mce_display_unref(display);
+        g_assert(!finalized);
+        g_assert(mce_display_new() == display);
+        g_assert(display->valid);
+
+        /* With lingering disabled, it goes without waiting */
+        mce_linger_set_time(0);
+        mce_display_unref(display);
+        test_run_until(test_flag, &finalized);
+        test_provider_stop(&provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * expire
+ *==========================================================================*/
+
+static
+void
+test_expire(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestProvider provider;
+        MceDisplay* display;
+        gboolean finalized;
+        gint64 released;
+
+        memset(&provider, 0, sizeof(provider));
+        test_provider_start(&provider, test_record_unity(TRUE));
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        mce_linger_set_time(100);
+        display = test_display_new(&finalized);
+
+        /* Not requested again in time, the timer lets it go */
+        released = g_get_monotonic_time();
+        mce_display_unref(display);
+        g_assert(!finalized);
+        test_run_until(test_flag, &finalized);
+        g_assert(g_get_monotonic_time() - released >= 100 * 1000);
+
+        /* And the next one starts from scratch */
+        display = mce_display_new();
+        g_assert(!display->valid);
+        finalized = FALSE;
+        g_object_weak_ref(G_OBJECT(display), test_finalized, &finalized);
+        mce_display_unref(display);
+        test_run_until(test_flag, &finalized);
+        test_provider_stop(&provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/linger/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("revive"), test_revive);
+    g_test_add_func(TEST_("expire"), test_expire);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
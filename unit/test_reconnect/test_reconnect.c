@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_call.h"
+#include "mce_display.h"
+
+#include <string.h>
+
+/*
+ * Restarts the system bus under a live MceDisplay and checks that it
+ * comes back, with the state served by the new bus.
+ */
+
+typedef struct test_reconnect {
+    TestProvider provider;
+    MceDisplay* display;
+} TestReconnect;
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_invalid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return !display->valid;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+test_restart(
+    gboolean private_bus)
+{
+    TestReconnect test;
+    MceCallStats stats;
+    GDBusConnection* shared = NULL;
+    gulong id[2];
+
+    memset(&test, 0, sizeof(test));
+    test_provider_start(&test.provider, test_record_unity(TRUE));
+    if (private_bus) {
+        mce_bus_set_private(TRUE);
+    } else {
+        /*
+         * The shared connection would take the whole process down with
+         * it, unless the application says otherwise. Holding on to it
+         * also keeps GLib handing out the closed one after the restart.
+         */
+        shared = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
+        g_assert(shared);
+        g_dbus_connection_set_exit_on_close(shared, FALSE);
+    }
+    mce_bus_set_backend(MCE_BACKEND_UNITY);
+    test.display = mce_display_new();
+    id[0] = mce_display_add_valid_changed_handler(test.display,
+        test_changed, NULL);
+    id[1] = mce_display_add_state_changed_handler(test.display,
+        test_changed, NULL);
+    test_run_until(test_display_on, test.display);
+
+    /* The bus goes away, and comes back at a different address */
+    test_provider_stop(&test.provider);
+    test_run_until(test_display_invalid, test.display);
+    test_provider_start(&test.provider, test_record_unity(FALSE));
+    test_run_until(test_display_off, test.display);
+
+    mce_call_get_stats(&stats);
+    g_assert(stats.reconnects > 0);
+    g_assert(stats.recovery > 0);
+
+    mce_display_remove_all_handlers(test.display, id);
+    mce_display_unref(test.display);
+    test_provider_stop(&test.provider);
+    if (shared) {
+        g_object_unref(shared);
+    }
+}
+
+/*==========================================================================*
+ * private
+ *==========================================================================*/
+
+static
+void
+test_private(
+    void)
+{
+    if (g_test_subprocess()) {
+        test_restart(TRUE);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * shared
+ *==========================================================================*/
+
+static
+void
+test_shared(
+    void)
+{
+    if (g_test_subprocess()) {
+        test_restart(FALSE);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/reconnect/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("private"), test_private);
+    g_test_add_func(TEST_("shared"), test_shared);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
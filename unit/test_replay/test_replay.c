@@ -0,0 +1,840 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_battery.h"
+#include "mce_bus.h"
+#include "mce_cache_p.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_record.h"
+#include "mce_record_p.h"
+#include "mce_proxy.h"
+#include "mce_tklock.h"
+
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+static
+void
+test_changed(
+    gpointer object,
+    void* arg)
+{
+    test_check();
+}
+
+/*==========================================================================*
+ * unity
+ *==========================================================================*/
+
+static
+gboolean
+test_unity_done(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+test_unity(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestProvider test;
+        MceDisplay* display;
+        gulong id[2];
+
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, MCE_INTERFACE,
+            "getDisplayPowerState", g_variant_new("(i)", 1)));
+        test_record_add(rec, MCE_RECORD_SIGNAL, g_variant_new
+            (MCE_RECORD_SIGNAL_PAYLOAD, MCE_INTERFACE,
+            "DisplayPowerStateChange", g_variant_new("(ii)", 0, 0)));
+        test_provider_start(&test, rec);
+
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        display = mce_display_new();
+        id[0] = mce_display_add_valid_changed_handler(display,
+            (MceDisplayFunc)test_changed, NULL);
+        id[1] = mce_display_add_state_changed_handler(display,
+            (MceDisplayFunc)test_changed, NULL);
+        test_run_until(test_unity_done, display);
+        mce_display_remove_all_handlers(display, id);
+        mce_display_unref(display);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * tklock_unity
+ *==========================================================================*/
+
+static
+gboolean
+test_tklock_unity_done(
+    void* arg)
+{
+    MceTklock* tklock = arg;
+
+    return !tklock->provisional;
+}
+
+static
+void
+test_tklock_unity(
+    void)
+{
+    if (g_test_subprocess()) {
+        char* dir = g_dir_make_tmp("test_replay_XXXXXX", NULL);
+        char* cache_dir = g_build_filename(dir, "mce-glib", NULL);
+        char* cache_file = g_build_filename(cache_dir, "state", NULL);
+        TestProvider test;
+        MceTklock* tklock;
+        gulong id[3];
+
+        /* Unlocked according to the cache */
+        g_assert(dir);
+        g_assert(g_setenv("XDG_RUNTIME_DIR", dir, TRUE));
+        mce_cache_set_enabled(TRUE);
+        mce_cache_set(MCE_CACHE_TKLOCK_MODE, MCE_TKLOCK_MODE_UNLOCKED);
+
+        memset(&test, 0, sizeof(test));
+        test_provider_start(&test, test_record_unity(TRUE));
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        tklock = mce_tklock_new();
+        g_assert(tklock->provisional);
+        g_assert(tklock->mode == MCE_TKLOCK_MODE_UNLOCKED);
+        g_assert(!tklock->locked);
+        id[0] = mce_tklock_add_valid_changed_handler(tklock,
+            (MceTklockFunc)test_changed, NULL);
+        id[1] = mce_tklock_add_mode_changed_handler(tklock,
+            (MceTklockFunc)test_changed, NULL);
+        id[2] = mce_tklock_add_locked_changed_handler(tklock,
+            (MceTklockFunc)test_changed, NULL);
+
+        /* Unity.Screen can't confirm it, back to the default */
+        test_run_until(test_tklock_unity_done, tklock);
+        g_assert(!tklock->valid);
+        g_assert(tklock->mode == MCE_TKLOCK_MODE_LOCKED);
+        g_assert(tklock->locked);
+
+        mce_tklock_remove_all_handlers(tklock, id);
+        mce_tklock_unref(tklock);
+        test_provider_stop(&test);
+        mce_cache_set_enabled(FALSE);
+        g_unlink(cache_file);
+        g_rmdir(cache_dir);
+        g_rmdir(dir);
+        g_free(cache_file);
+        g_free(cache_dir);
+        g_free(dir);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * nokia
+ *==========================================================================*/
+
+typedef struct test_nokia {
+    MceDisplay* display;
+    MceBattery* battery;
+} TestNokia;
+
+static
+gboolean
+test_nokia_done(
+    void* arg)
+{
+    TestNokia* test = arg;
+
+    return test->display->valid &&
+        test->display->state == MCE_DISPLAY_STATE_OFF &&
+        test->battery->valid && test->battery->level == 55 &&
+        test->battery->status == MCE_BATTERY_OK;
+}
+
+static
+void
+test_nokia(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestProvider test;
+        TestNokia nokia;
+        gulong display_id[2];
+        gulong battery_id[3];
+
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_display_status", g_variant_new("(s)", "on")));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_battery_level", g_variant_new("(i)", 42)));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_battery_status", g_variant_new("(s)", "ok")));
+        test_record_add(rec, MCE_RECORD_SIGNAL, g_variant_new
+            (MCE_RECORD_SIGNAL_PAYLOAD, NOKIA_MCE_SIGNAL_INTERFACE,
+            "display_status_ind", g_variant_new("(s)", "off")));
+        test_record_add(rec, MCE_RECORD_SIGNAL, g_variant_new
+            (MCE_RECORD_SIGNAL_PAYLOAD, NOKIA_MCE_SIGNAL_INTERFACE,
+            "battery_level_ind", g_variant_new("(i)", 55)));
+        test_provider_start(&test, rec);
+
+        /* Whether signals or queries get there first, the end is same */
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        nokia.display = mce_display_new();
+        nokia.battery = mce_battery_new();
+        display_id[0] = mce_display_add_valid_changed_handler
+            (nokia.display, (MceDisplayFunc)test_changed, NULL);
+        display_id[1] = mce_display_add_state_changed_handler
+            (nokia.display, (MceDisplayFunc)test_changed, NULL);
+        battery_id[0] = mce_battery_add_valid_changed_handler
+            (nokia.battery, (MceBatteryFunc)test_changed, NULL);
+        battery_id[1] = mce_battery_add_level_changed_handler
+            (nokia.battery, (MceBatteryFunc)test_changed, NULL);
+        battery_id[2] = mce_battery_add_status_changed_handler
+            (nokia.battery, (MceBatteryFunc)test_changed, NULL);
+        test_run_until(test_nokia_done, &nokia);
+        mce_display_remove_all_handlers(nokia.display, display_id);
+        mce_battery_remove_all_handlers(nokia.battery, battery_id);
+        mce_display_unref(nokia.display);
+        mce_battery_unref(nokia.battery);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * charger
+ *==========================================================================*/
+
+static
+gboolean
+test_charger_on(
+    void* arg)
+{
+    MceCharger* charger = arg;
+
+    return charger->valid && charger->state == MCE_CHARGER_ON;
+}
+
+static
+void
+test_charger(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestProvider test;
+        MceCharger* charger;
+        gulong id[2];
+
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_charger_state", g_variant_new("(s)", "off")));
+        test_record_add(rec, MCE_RECORD_SIGNAL, g_variant_new
+            (MCE_RECORD_SIGNAL_PAYLOAD, NOKIA_MCE_SIGNAL_INTERFACE,
+            "charger_state_ind", g_variant_new("(s)", "on")));
+        test_provider_start(&test, rec);
+
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        charger = mce_charger_new();
+        id[0] = mce_charger_add_valid_changed_handler(charger,
+            (MceChargerFunc)test_changed, NULL);
+        id[1] = mce_charger_add_state_changed_handler(charger,
+            (MceChargerFunc)test_changed, NULL);
+        test_run_until(test_charger_on, charger);
+        mce_charger_remove_all_handlers(charger, id);
+        mce_charger_unref(charger);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * limiter
+ *==========================================================================*/
+
+#define TEST_LIMITER_INTERVAL_MS (500)
+
+typedef struct test_limiter_sub {
+    guint calls;
+    guint level;
+    gint64 time;
+} TestLimiterSub;
+
+typedef struct test_limiter {
+    TestProvider provider;
+    MceBattery* battery;
+    TestLimiterSub delta;
+    TestLimiterSub interval;
+    guint level;
+    gboolean expired;
+} TestLimiter;
+
+static
+void
+test_limiter_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    TestLimiterSub* sub = arg;
+
+    sub->calls++;
+    sub->level = battery->level;
+    sub->time = g_get_monotonic_time();
+    test_check();
+}
+
+static
+gboolean
+test_limiter_valid(
+    void* arg)
+{
+    TestLimiter* test = arg;
+
+    return test->battery->valid;
+}
+
+static
+gboolean
+test_limiter_level(
+    void* arg)
+{
+    TestLimiter* test = arg;
+
+    return test->battery->level == test->level;
+}
+
+static
+gboolean
+test_limiter_interval_calls(
+    void* arg)
+{
+    TestLimiter* test = arg;
+
+    return test->interval.calls == 2;
+}
+
+static
+gboolean
+test_limiter_expired(
+    void* arg)
+{
+    TestLimiter* test = arg;
+
+    return test->expired;
+}
+
+static
+gboolean
+test_limiter_timeout(
+    gpointer arg)
+{
+    TestLimiter* test = arg;
+
+    test->expired = TRUE;
+    test_check();
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_limiter_set_level(
+    TestLimiter* test,
+    guint level)
+{
+    test->level = level;
+    test_provider_emit(&test->provider, NOKIA_MCE_SIGNAL_PATH,
+        NOKIA_MCE_SIGNAL_INTERFACE, "battery_level_ind",
+        g_variant_new("(i)", level));
+    test_run_until(test_limiter_level, test);
+}
+
+static
+void
+test_limiter_wait(
+    TestLimiter* test,
+    guint ms)
+{
+    test->expired = FALSE;
+    g_timeout_add(ms, test_limiter_timeout, test);
+    test_run_until(test_limiter_expired, test);
+}
+
+static
+void
+test_limiter(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestLimiter test;
+        MceHandlerStats stats;
+        gulong id[4];
+        gint64 start;
+
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_battery_level", g_variant_new("(i)", 50)));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_battery_status", g_variant_new("(s)", "ok")));
+        test_provider_start(&test.provider, rec);
+
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        test.battery = mce_battery_new();
+        id[0] = mce_battery_add_valid_changed_handler(test.battery,
+            (MceBatteryFunc)test_changed, NULL);
+        id[1] = mce_battery_add_level_changed_handler(test.battery,
+            (MceBatteryFunc)test_changed, NULL);
+        test_run_until(test_limiter_valid, &test);
+        test.level = 50;
+        test_run_until(test_limiter_level, &test);
+
+        /* At least 5% from what the subscriber has seen */
+        id[2] = mce_battery_add_level_changed_handler_limited(test.battery,
+            5, 0, test_limiter_changed, &test.delta);
+        test_limiter_set_level(&test, 52);
+        g_assert(!test.delta.calls);
+        test_limiter_set_level(&test, 55);
+        g_assert(test.delta.calls == 1);
+        g_assert(test.delta.level == 55);
+        test_limiter_set_level(&test, 51);
+        g_assert(test.delta.calls == 1);
+        test_limiter_set_level(&test, 50);
+        g_assert(test.delta.calls == 2);
+        g_assert(test.delta.level == 50);
+
+        /* Not more often than once per interval, any change will do */
+        id[3] = mce_battery_add_level_changed_handler_limited(test.battery,
+            0, TEST_LIMITER_INTERVAL_MS, test_limiter_changed,
+            &test.interval);
+
+        /* Back where it was by the time the interval expires, no call */
+        test_limiter_set_level(&test, 49);
+        test_limiter_set_level(&test, 50);
+        test_limiter_wait(&test, TEST_LIMITER_INTERVAL_MS * 3 / 2);
+        g_assert(!test.interval.calls);
+
+        /* The interval has expired, delivered right away */
+        start = g_get_monotonic_time();
+        test_limiter_set_level(&test, 47);
+        g_assert(test.interval.calls == 1);
+        g_assert(test.interval.level == 47);
+
+        /* Postponed, then delivered with the latest level */
+        test_limiter_set_level(&test, 46);
+        test_limiter_set_level(&test, 45);
+        g_assert(test.interval.calls == 1);
+        test_run_until(test_limiter_interval_calls, &test);
+        g_assert(test.interval.level == 45);
+        g_assert(test.interval.time - start >=
+            TEST_LIMITER_INTERVAL_MS * 1000);
+
+        /* Both are timed like any other handler */
+        g_assert(test_handler_stats(G_CALLBACK(test_limiter_changed),
+            &test.delta, &stats));
+        g_assert(stats.calls == test.delta.calls);
+        g_assert(test_handler_stats(G_CALLBACK(test_limiter_changed),
+            &test.interval, &stats));
+        g_assert(stats.calls == test.interval.calls);
+
+        mce_battery_remove_all_handlers(test.battery, id);
+        mce_battery_unref(test.battery);
+        test_provider_stop(&test.provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * fresh
+ *==========================================================================*/
+
+typedef struct test_fresh {
+    MceDisplay* display;
+    guint calls;
+    gboolean fresh;
+} TestFresh;
+
+static
+void
+test_fresh_done(
+    MceDisplay* display,
+    gboolean fresh,
+    void* arg)
+{
+    TestFresh* test = arg;
+
+    test->calls++;
+    test->fresh = fresh;
+    test_check();
+}
+
+static
+gboolean
+test_fresh_called(
+    void* arg)
+{
+    TestFresh* test = arg;
+
+    return test->calls > 0;
+}
+
+static
+gboolean
+test_fresh_valid(
+    void* arg)
+{
+    TestFresh* test = arg;
+
+    return test->display->valid;
+}
+
+static
+void
+test_fresh_get(
+    TestFresh* test,
+    guint max_age_ms)
+{
+    test->calls = 0;
+    test->fresh = FALSE;
+    g_assert(!mce_display_get_state_fresh(test->display, max_age_ms,
+        test_fresh_done, test));
+    g_assert(!test->calls);
+    test_run_until(test_fresh_called, test);
+    g_assert(test->calls == 1);
+}
+
+static
+void
+test_fresh(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestProvider test;
+        TestFresh fresh;
+        gulong id[2];
+
+        memset(&test, 0, sizeof(test));
+        memset(&fresh, 0, sizeof(fresh));
+        test_provider_start(&test, test_record_unity(TRUE));
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        fresh.display = mce_display_new();
+        id[0] = mce_display_add_valid_changed_handler(fresh.display,
+            (MceDisplayFunc)test_changed, NULL);
+        id[1] = mce_display_add_state_changed_handler(fresh.display,
+            (MceDisplayFunc)test_changed, NULL);
+        test_run_until(test_fresh_valid, &fresh);
+
+        /* Just confirmed, no need to ask */
+        g_assert(mce_display_get_state_fresh(fresh.display, 60000,
+            test_fresh_done, &fresh));
+        g_assert(fresh.calls == 1);
+        g_assert(fresh.fresh);
+
+        /* Nothing is fresh enough, asks MCE */
+        g_usleep(1000);
+        test_fresh_get(&fresh, 0);
+        g_assert(fresh.fresh);
+        g_assert(fresh.display->valid);
+        g_assert(fresh.display->state == MCE_DISPLAY_STATE_ON);
+
+        mce_display_remove_all_handlers(fresh.display, id);
+        mce_display_unref(fresh.display);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+static
+void
+test_fresh_failed(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        TestProvider test;
+        TestFresh fresh;
+        gulong id[2];
+
+        /* Nothing recorded for get_display_status, the queries fail */
+        memset(&test, 0, sizeof(test));
+        memset(&fresh, 0, sizeof(fresh));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_provider_start(&test, rec);
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        fresh.display = mce_display_new();
+        id[0] = mce_display_add_valid_changed_handler(fresh.display,
+            (MceDisplayFunc)test_changed, NULL);
+        id[1] = mce_display_add_state_changed_handler(fresh.display,
+            (MceDisplayFunc)test_changed, NULL);
+
+        /* Nothing known at all */
+        test_fresh_get(&fresh, 0);
+        g_assert(!fresh.fresh);
+        g_assert(!fresh.display->valid);
+
+        /* Known but stale */
+        test_provider_emit(&test, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+            g_variant_new("(s)", "on"));
+        test_run_until(test_fresh_valid, &fresh);
+        g_usleep(1000);
+        test_fresh_get(&fresh, 0);
+        g_assert(!fresh.fresh);
+        g_assert(fresh.display->valid);
+        g_assert(fresh.display->state == MCE_DISPLAY_STATE_ON);
+
+        mce_display_remove_all_handlers(fresh.display, id);
+        mce_display_unref(fresh.display);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * spoof
+ *==========================================================================*/
+
+typedef struct test_spoof {
+    MceDisplay* display;
+    guint changes;
+} TestSpoof;
+
+static
+void
+test_spoof_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    TestSpoof* spoof = arg;
+
+    spoof->changes++;
+    test_check();
+}
+
+static
+gboolean
+test_spoof_on(
+    void* arg)
+{
+    TestSpoof* spoof = arg;
+
+    return spoof->display->valid &&
+        spoof->display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_spoof_off(
+    void* arg)
+{
+    TestSpoof* spoof = arg;
+
+    return spoof->display->valid &&
+        spoof->display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+void
+test_spoof_emit(
+    GDBusConnection* conn,
+    const char* dest,
+    int state)
+{
+    g_assert(g_dbus_connection_emit_signal(conn, dest, MCE_SIGNAL_PATH,
+        MCE_INTERFACE, "DisplayPowerStateChange",
+        g_variant_new("(ii)", state, 0), NULL));
+    g_assert(g_dbus_connection_flush_sync(conn, NULL, NULL));
+}
+
+static
+void
+test_spoof_sync(
+    GDBusConnection* conn)
+{
+    /* Once the bus has replied, it has routed what we sent before */
+    GVariant* reply = g_dbus_connection_call_sync(conn,
+        "org.freedesktop.DBus", "/org/freedesktop/DBus",
+        "org.freedesktop.DBus", "GetId", NULL, NULL,
+        G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+
+    g_assert(reply);
+    g_variant_unref(reply);
+}
+
+static
+void
+test_spoof(
+    void)
+{
+    if (g_test_subprocess()) {
+        const char* address;
+        const char* provider;
+        const char* self;
+        const char** names = NULL;
+        GDBusConnection* spoofer;
+        GVariant* reply;
+        TestProvider test;
+        TestSpoof spoof;
+        gulong id[2];
+        int i;
+
+        memset(&test, 0, sizeof(test));
+        memset(&spoof, 0, sizeof(spoof));
+        test_provider_start(&test, test_record_unity(TRUE));
+
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        mce_bus_set_private(TRUE);
+        spoof.display = mce_display_new();
+        id[0] = mce_display_add_valid_changed_handler(spoof.display,
+            test_spoof_changed, &spoof);
+        id[1] = mce_display_add_state_changed_handler(spoof.display,
+            test_spoof_changed, &spoof);
+        test_run_until(test_spoof_on, &spoof);
+        spoof.changes = 0;
+
+        /* Send "off" directly to everyone but the provider */
+        address = g_getenv("DBUS_SYSTEM_BUS_ADDRESS");
+        spoofer = g_dbus_connection_new_for_address_sync(address,
+            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+            G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION, NULL, NULL,
+            NULL);
+        g_assert(spoofer);
+        provider = g_dbus_connection_get_unique_name(test.bus.conn);
+        self = g_dbus_connection_get_unique_name(spoofer);
+        reply = g_dbus_connection_call_sync(spoofer, "org.freedesktop.DBus",
+            "/org/freedesktop/DBus", "org.freedesktop.DBus", "ListNames",
+            NULL, G_VARIANT_TYPE("(as)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+            NULL);
+        g_assert(reply);
+        g_variant_get(reply, "(^a&s)", &names);
+        for (i = 0; names[i]; i++) {
+            if (names[i][0] == ':' && g_strcmp0(names[i], provider) &&
+                g_strcmp0(names[i], self)) {
+                test_spoof_emit(spoofer, names[i], 0);
+            }
+        }
+        g_free(names);
+        g_variant_unref(reply);
+        test_spoof_sync(spoofer);
+
+        /*
+         * Now the real thing, on then off. If the spoofed signal got
+         * through, that's off, on and off, i.e. three changes.
+         */
+        test_spoof_emit(test.bus.conn, NULL, 1);
+        test_spoof_emit(test.bus.conn, NULL, 0);
+        test_run_until(test_spoof_off, &spoof);
+        g_assert(spoof.changes == 1);
+
+        g_dbus_connection_close_sync(spoofer, NULL, NULL);
+        g_object_unref(spoofer);
+        mce_display_remove_all_handlers(spoof.display, id);
+        mce_display_unref(spoof.display);
+        test_provider_stop(&test);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/replay/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("unity"), test_unity);
+    g_test_add_func(TEST_("tklock_unity"), test_tklock_unity);
+    g_test_add_func(TEST_("nokia"), test_nokia);
+    g_test_add_func(TEST_("charger"), test_charger);
+    g_test_add_func(TEST_("limiter"), test_limiter);
+    g_test_add_func(TEST_("fresh"), test_fresh);
+    g_test_add_func(TEST_("fresh_failed"), test_fresh_failed);
+    g_test_add_func(TEST_("spoof"), test_spoof);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
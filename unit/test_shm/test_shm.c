@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#define _GNU_SOURCE /* memfd_create */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_display.h"
+#include "mce_shm_p.h"
+
+#include <glib-unix.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/* These must match mce_shm.c */
+#define TEST_SHM_SOCKET "mce-glib-state"
+#define TEST_SHM_MAGIC (0x5345434d)
+#define TEST_SHM_VERSION (1)
+#define TEST_SHM_PAGE_SIZE (4096)
+
+typedef struct test_shm_page {
+    guint32 magic;
+    guint32 version;
+    gint seq;
+    gint display_valid;
+    gint display_state;
+    gint tklock_valid;
+    gint tklock_mode;
+    gint tklock_locked;
+} TestShmPage;
+
+#define TEST_MAX_FDS (3)
+
+/*
+ * Stands in for the publisher process. The first reader which
+ * connects gets the page and the eventfd, followed by as many
+ * extra descriptors as it takes to send nfds of them.
+ */
+
+typedef struct test_publisher {
+    int sock;
+    guint sock_id;
+    int client;
+    int memfd;
+    int efd;
+    TestShmPage* page;
+    guint nfds;
+} TestPublisher;
+
+typedef struct test_reader {
+    guint changed;
+    guint lost;
+} TestReader;
+
+static
+guint
+test_fd_count(
+    void)
+{
+    GDir* dir = g_dir_open("/proc/self/fd", 0, NULL);
+    guint n = 0;
+
+    g_assert(dir);
+    while (g_dir_read_name(dir)) {
+        n++;
+    }
+    g_dir_close(dir);
+    return n;
+}
+
+static
+gboolean
+test_publisher_accept(
+    gint fd,
+    GIOCondition condition,
+    gpointer arg)
+{
+    TestPublisher* pub = arg;
+    char byte = 0;
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr* cmsg;
+    int fds[TEST_MAX_FDS];
+    guint i;
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+
+    pub->client = accept(fd, NULL, NULL);
+    g_assert(pub->client >= 0);
+
+    fds[0] = pub->memfd;
+    fds[1] = pub->efd;
+    for (i = 2; i < pub->nfds; i++) {
+        fds[i] = dup(pub->efd);
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(pub->nfds * sizeof(int));
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(pub->nfds * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, pub->nfds * sizeof(int));
+    g_assert(sendmsg(pub->client, &msg, MSG_NOSIGNAL) == 1);
+
+    /* The reader has its own copies now */
+    for (i = 2; i < pub->nfds; i++) {
+        close(fds[i]);
+    }
+    pub->sock_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_publisher_update(
+    TestPublisher* pub,
+    MCE_DISPLAY_STATE state)
+{
+    TestShmPage* page = pub->page;
+    const guint64 one = 1;
+
+    g_atomic_int_inc(&page->seq);
+    __sync_synchronize();
+    page->display_valid = TRUE;
+    page->display_state = state;
+    __sync_synchronize();
+    g_atomic_int_inc(&page->seq);
+    g_assert(write(pub->efd, &one, sizeof(one)) == sizeof(one));
+}
+
+static
+void
+test_publisher_start(
+    TestPublisher* pub,
+    guint nfds)
+{
+    const gsize len = strlen(TEST_SHM_SOCKET);
+    struct sockaddr_un sa;
+    void* page;
+
+    g_assert(nfds <= TEST_MAX_FDS);
+    memset(pub, 0, sizeof(*pub));
+    pub->client = -1;
+    pub->nfds = nfds;
+    pub->memfd = memfd_create(TEST_SHM_SOCKET, MFD_CLOEXEC |
+        MFD_ALLOW_SEALING);
+    g_assert(pub->memfd >= 0);
+    g_assert(ftruncate(pub->memfd, TEST_SHM_PAGE_SIZE) == 0);
+    g_assert(fcntl(pub->memfd, F_ADD_SEALS, F_SEAL_SHRINK |
+        F_SEAL_GROW) == 0);
+    page = mmap(NULL, TEST_SHM_PAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_SHARED, pub->memfd, 0);
+    g_assert(page != MAP_FAILED);
+    pub->page = page;
+    pub->page->magic = TEST_SHM_MAGIC;
+    pub->page->version = TEST_SHM_VERSION;
+    pub->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    g_assert(pub->efd >= 0);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    memcpy(sa.sun_path + 1, TEST_SHM_SOCKET, len);
+    pub->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    g_assert(pub->sock >= 0);
+    g_assert(bind(pub->sock, (struct sockaddr*)&sa,
+        offsetof(struct sockaddr_un, sun_path) + 1 + len) == 0);
+    g_assert(listen(pub->sock, 1) == 0);
+    pub->sock_id = g_unix_fd_add(pub->sock, G_IO_IN,
+        test_publisher_accept, pub);
+}
+
+static
+void
+test_publisher_stop(
+    TestPublisher* pub)
+{
+    if (pub->sock_id) {
+        g_source_remove(pub->sock_id);
+    }
+    if (pub->client >= 0) {
+        close(pub->client);
+    }
+    close(pub->sock);
+    close(pub->efd);
+    munmap(pub->page, TEST_SHM_PAGE_SIZE);
+    close(pub->memfd);
+}
+
+static
+void
+test_reader_changed(
+    MceShm* shm,
+    void* arg)
+{
+    TestReader* reader = arg;
+
+    reader->changed++;
+    test_check();
+}
+
+static
+void
+test_reader_lost(
+    MceShm* shm,
+    void* arg)
+{
+    TestReader* reader = arg;
+
+    reader->lost++;
+    test_check();
+}
+
+static
+gboolean
+test_reader_is_changed(
+    void* arg)
+{
+    TestReader* reader = arg;
+
+    return reader->changed > 0;
+}
+
+static
+gboolean
+test_reader_is_lost(
+    void* arg)
+{
+    TestReader* reader = arg;
+
+    return reader->lost > 0;
+}
+
+/*==========================================================================*
+ * read
+ *==========================================================================*/
+
+static
+void
+test_read(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestPublisher pub;
+        TestReader reader;
+        MceShmState state;
+        MceShm* shm;
+
+        memset(&reader, 0, sizeof(reader));
+        mce_shm_set_enabled(TRUE);
+        test_publisher_start(&pub, 2);
+        test_publisher_update(&pub, MCE_DISPLAY_STATE_OFF);
+        shm = mce_shm_attach(test_reader_changed, test_reader_lost,
+            &reader);
+        g_assert(shm);
+        test_run_until(test_reader_is_changed, &reader);
+        g_assert(mce_shm_read(shm, &state));
+        g_assert(state.display_valid);
+        g_assert(state.display_state == MCE_DISPLAY_STATE_OFF);
+
+        /* Updates are signalled via the eventfd */
+        reader.changed = 0;
+        test_publisher_update(&pub, MCE_DISPLAY_STATE_ON);
+        test_run_until(test_reader_is_changed, &reader);
+        g_assert(mce_shm_read(shm, &state));
+        g_assert(state.display_state == MCE_DISPLAY_STATE_ON);
+
+        /* And the publisher going away via the socket */
+        test_publisher_stop(&pub);
+        test_run_until(test_reader_is_lost, &reader);
+        mce_shm_detach(shm);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * fds
+ *==========================================================================*/
+
+static
+void
+test_fds(
+    gconstpointer data)
+{
+    if (g_test_subprocess()) {
+        TestPublisher pub;
+        TestReader reader;
+        MceShm* shm;
+        guint count;
+
+        /* The default context has a descriptor of its own */
+        g_main_context_default();
+        count = test_fd_count();
+
+        memset(&reader, 0, sizeof(reader));
+        mce_shm_set_enabled(TRUE);
+        test_publisher_start(&pub, GPOINTER_TO_UINT(data));
+        shm = mce_shm_attach(test_reader_changed, test_reader_lost,
+            &reader);
+        g_assert(shm);
+
+        /* The reader must give up without keeping anything */
+        test_run_until(test_reader_is_lost, &reader);
+        g_assert(!reader.changed);
+        mce_shm_detach(shm);
+        test_publisher_stop(&pub);
+        g_assert_cmpuint(test_fd_count(), ==, count);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+/*==========================================================================*
+ * reattach
+ *==========================================================================*/
+
+static
+void
+test_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    test_check();
+}
+
+static
+gboolean
+test_display_on(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_ON;
+}
+
+static
+gboolean
+test_display_off(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_OFF;
+}
+
+static
+gboolean
+test_display_invalid(
+    void* arg)
+{
+    MceDisplay* display = arg;
+
+    return !display->valid;
+}
+
+static
+void
+test_fresh_done(
+    MceDisplay* display,
+    gboolean fresh,
+    void* arg)
+{
+    g_assert(fresh);
+}
+
+static
+void
+test_reattach(
+    void)
+{
+    if (g_test_subprocess()) {
+        TestProvider provider;
+        TestPublisher pub;
+        MceDisplay* display;
+        gulong id[2];
+
+        /* No publisher, talking to MCE directly */
+        memset(&provider, 0, sizeof(provider));
+        test_provider_start(&provider, test_record_unity(TRUE));
+        mce_bus_set_backend(MCE_BACKEND_UNITY);
+        mce_shm_set_enabled(TRUE);
+        display = mce_display_new();
+        id[0] = mce_display_add_valid_changed_handler(display,
+            test_changed, NULL);
+        id[1] = mce_display_add_state_changed_handler(display,
+            test_changed, NULL);
+        test_run_until(test_display_on, display);
+
+        /* MCE comes back together with the publisher */
+        test_provider_stop(&provider);
+        test_run_until(test_display_invalid, display);
+        test_publisher_start(&pub, 2);
+        test_publisher_update(&pub, MCE_DISPLAY_STATE_OFF);
+        test_provider_start(&provider, test_record_unity(TRUE));
+
+        /* MCE says on, the page says off and wins */
+        test_run_until(test_display_off, display);
+        test_publisher_update(&pub, MCE_DISPLAY_STATE_ON);
+        test_run_until(test_display_on, display);
+
+        /* The page is always fresh */
+        g_assert(mce_display_get_state_fresh(display, 0,
+            test_fresh_done, NULL));
+
+        mce_display_remove_all_handlers(display, id);
+        mce_display_unref(display);
+        test_publisher_stop(&pub);
+        test_provider_stop(&provider);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/shm/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("read"), test_read);
+    g_test_add_data_func(TEST_("fds/one"), GUINT_TO_POINTER(1), test_fds);
+    g_test_add_data_func(TEST_("fds/three"), GUINT_TO_POINTER(3),
+        test_fds);
+    g_test_add_func(TEST_("reattach"), test_reattach);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ * Contact: Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the name of Jolla Ltd nor the names of its contributors may
+ *      be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_bus.h"
+#include "mce_proxy.h"
+#include "mce_record_p.h"
+#include "mce_state_set.h"
+
+#include <string.h>
+
+#define TEST_BOTH (MCE_STATE_DISPLAY | MCE_STATE_TKLOCK)
+#define TEST_IDLE_MS (100)
+
+typedef struct test_state_set {
+    TestProvider provider;
+    MceDisplay* display;
+    MceTklock* tklock;
+    MceStateSet* set;
+    MceStateSnapshot last;
+    guint calls;
+} TestStateSet;
+
+static
+void
+test_state_set_cb(
+    MceStateSet* set,
+    const MceStateSnapshot* snapshot,
+    void* arg)
+{
+    TestStateSet* test = arg;
+
+    test->calls++;
+    test->last = *snapshot;
+    test_check();
+}
+
+static
+gboolean
+test_valid(
+    void* arg)
+{
+    TestStateSet* test = arg;
+
+    return test->last.valid == TEST_BOTH;
+}
+
+static
+gboolean
+test_called(
+    void* arg)
+{
+    TestStateSet* test = arg;
+
+    return test->calls > 0;
+}
+
+static
+gboolean
+test_on_unlocked(
+    void* arg)
+{
+    TestStateSet* test = arg;
+
+    return test->last.display_state == MCE_DISPLAY_STATE_ON &&
+        test->last.tklock_mode == MCE_TKLOCK_MODE_UNLOCKED;
+}
+
+static
+gboolean
+test_timeout_done(
+    gpointer arg)
+{
+    *((gboolean*)arg) = TRUE;
+    test_check();
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+test_flag(
+    void* arg)
+{
+    return *((gboolean*)arg);
+}
+
+/*==========================================================================*
+ * merge
+ *==========================================================================*/
+
+static
+void
+test_merge(
+    void)
+{
+    if (g_test_subprocess()) {
+        GByteArray* rec = test_record_new();
+        MceStateSnapshot snapshot;
+        TestStateSet test;
+        gboolean idle = FALSE;
+
+        /* Native mce with the display off and tklock locked */
+        memset(&test, 0, sizeof(test));
+        test_record_add(rec, MCE_RECORD_NAME_APPEARED, g_variant_new
+            (MCE_RECORD_NAME_APPEARED_PAYLOAD, NOKIA_MCE_SERVICE, ":1.1"));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_display_status", g_variant_new("(s)", "off")));
+        test_record_add(rec, MCE_RECORD_REPLY, g_variant_new
+            (MCE_RECORD_REPLY_PAYLOAD, NOKIA_MCE_REQUEST_INTERFACE,
+            "get_tklock_mode", g_variant_new("(s)", "locked")));
+        test_provider_start(&test.provider, rec);
+        mce_bus_set_backend(MCE_BACKEND_NOKIA);
+        test.display = mce_display_new();
+        test.tklock = mce_tklock_new();
+
+        /* Never invoked synchronously */
+        test.set = mce_state_set_new(test_state_set_cb, &test);
+        g_assert(mce_state_set_add(test.set, test.display));
+        g_assert(mce_state_set_add(test.set, test.tklock));
+        g_assert(mce_state_set_add(test.set, test.tklock));
+        g_assert(!test.calls);
+        mce_state_set_get(test.set, &snapshot);
+        g_assert_cmpuint(snapshot.members, ==, TEST_BOTH);
+        g_assert_cmpuint(snapshot.changed, ==, TEST_BOTH);
+
+        /* Both added in the same iteration, one callback */
+        test_run_until(test_called, &test);
+        g_assert_cmpuint(test.calls, ==, 1);
+        g_assert_cmpuint(test.last.changed, ==, TEST_BOTH);
+        test_run_until(test_valid, &test);
+        g_assert(test.last.display_state == MCE_DISPLAY_STATE_OFF);
+        g_assert(test.last.tklock_mode == MCE_TKLOCK_MODE_LOCKED);
+        g_assert(test.last.tklock_locked);
+
+        /* Changes coming one after another */
+        test_provider_emit(&test.provider, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "display_status_ind",
+            g_variant_new("(s)", "on"));
+        test_provider_emit(&test.provider, NOKIA_MCE_SIGNAL_PATH,
+            NOKIA_MCE_SIGNAL_INTERFACE, "tklock_mode_ind",
+            g_variant_new("(s)", "unlocked"));
+        test_run_until(test_on_unlocked, &test);
+        g_assert(!test.last.tklock_locked);
+        g_assert_cmpuint(test.last.valid, ==, TEST_BOTH);
+
+        /*
+         * mce going away invalidates both objects in the same iteration,
+         * the set reports that with a single callback.
+         */
+        test.calls = 0;
+        test_provider_stop(&test.provider);
+        test_run_until(test_called, &test);
+        g_assert_cmpuint(test.last.changed, ==, TEST_BOTH);
+        g_assert_cmpuint(test.last.valid, ==, 0);
+        g_timeout_add(TEST_IDLE_MS, test_timeout_done, &idle);
+        test_run_until(test_flag, &idle);
+        g_assert_cmpuint(test.calls, ==, 1);
+
+        /* Removed members are reported as changed, too */
+        test.calls = 0;
+        mce_state_set_remove(test.set, test.tklock);
+        mce_state_set_get(test.set, &snapshot);
+        g_assert_cmpuint(snapshot.members, ==, MCE_STATE_DISPLAY);
+        g_assert_cmpuint(snapshot.changed, ==, MCE_STATE_TKLOCK);
+        test_run_until(test_called, &test);
+        g_assert_cmpuint(test.last.members, ==, MCE_STATE_DISPLAY);
+        g_assert_cmpuint(test.last.changed, ==, MCE_STATE_TKLOCK);
+
+        mce_state_set_free(test.set);
+        mce_display_unref(test.display);
+        mce_tklock_unref(test.tklock);
+        return;
+    }
+    g_test_trap_subprocess(NULL, 0, 0);
+    g_test_trap_assert_passed();
+}
+
+#define TEST_(name) "/state_set/" name
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("merge"), test_merge);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */